@@ -0,0 +1,427 @@
+// Created: 2026-10-16
+
+#ifndef _APPLY_HPP_
+#define _APPLY_HPP_
+
+#include "cpu.hpp"
+#include "lut.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+namespace Lutools {
+
+/// \brief Number of pixels per stripe of parallel LUT application, 256 KiB of RGBA which sits comfortably in L2
+inline static constexpr std::size_t APPLY_STRIPE_PIXELS = static_cast<std::size_t>(1) << 16;
+
+/// \brief Replaces every pixel in [begin, end) with its mapped value, keeping the original alpha; portable version
+/// \param lut LUT data cache, generally returned by \c cacheLUTMap or \c loadCacheFromFile
+inline void remapPixelsScalar(Color* begin, Color* end, const Color* lut) noexcept {
+    for (Color* px = begin; px != end; ++px) {
+        Color mapped = lut[px->getHexRGB()];
+        mapped.a = px->a;
+        *px = mapped;
+    }
+}
+
+/// \brief Replaces every pixel in [begin, end) with its mapped value, keeping the original alpha; portable version
+/// \param lut Compact LUT data cache, generally returned by \c cacheLUTMap<ColorRGB>
+inline void remapPixelsScalar(Color* begin, Color* end, const ColorRGB* lut) noexcept {
+    for (Color* px = begin; px != end; ++px) {
+        const ColorRGB mapped = lut[px->getHexRGB()];
+        *px = { mapped.r, mapped.g, mapped.b, px->a };
+    }
+}
+
+/// \brief Replaces every packed RGB pixel in [begin, end) with its mapped value; portable version
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+template <typename EntryTy>
+void remapPixelsScalar(ColorRGB* begin, ColorRGB* end, const EntryTy* lut) noexcept {
+    for (ColorRGB* px = begin; px != end; ++px) {
+        const EntryTy& mapped = lut[px->r << 16 | px->g << 8 | px->b];
+        *px = { mapped.r, mapped.g, mapped.b };
+    }
+}
+
+/// \brief Converts a filter strength to the weight the blending kernels take, in 1/256 steps
+/// \param strength Weight of the mapped value against the original one, from 0 to 1
+inline unsigned getBlendWeight(float strength) noexcept {
+    return static_cast<unsigned>(std::lround(std::clamp(strength, 0.0f, 1.0f) * 256));
+}
+
+/// \brief Blends an original channel value with its mapped value, rounded to nearest
+/// \param weight Weight of the mapped value, from 0 to 256
+inline unsigned char blendChannel(unsigned char original, unsigned char mapped, unsigned weight) noexcept {
+    return static_cast<unsigned char>((original * (256 - weight) + mapped * weight + 128) >> 8);
+}
+
+/// \brief Replaces every pixel in [begin, end) with a blend of itself and its mapped value, keeping the original alpha;
+/// portable version
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param weight Weight of the mapped value, from 0 to 256
+template <typename EntryTy>
+void blendPixelsScalar(Color* begin, Color* end, const EntryTy* lut, unsigned weight) noexcept {
+    for (Color* px = begin; px != end; ++px) {
+        const EntryTy& mapped = lut[px->getHexRGB()];
+        *px = { blendChannel(px->r, mapped.r, weight), blendChannel(px->g, mapped.g, weight), blendChannel(px->b, mapped.b, weight), px->a };
+    }
+}
+
+/// \brief Replaces every packed RGB pixel in [begin, end) with a blend of itself and its mapped value; portable version
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param weight Weight of the mapped value, from 0 to 256
+template <typename EntryTy>
+void blendPixelsScalar(ColorRGB* begin, ColorRGB* end, const EntryTy* lut, unsigned weight) noexcept {
+    for (ColorRGB* px = begin; px != end; ++px) {
+        const EntryTy& mapped = lut[px->r << 16 | px->g << 8 | px->b];
+        *px = { blendChannel(px->r, mapped.r, weight), blendChannel(px->g, mapped.g, weight), blendChannel(px->b, mapped.b, weight) };
+    }
+}
+
+#if defined(LUTOOLS_X86)
+
+/// \brief AVX2 version of \c remapPixelsScalar, 8 pixels per gather
+LUTOOLS_TARGET("avx2") inline void remapPixelsAvx2(Color* begin, Color* end, const Color* lut) noexcept {
+    // Bytes (r, g, b, a) of each pixel become the little-endian index (b, g, r, 0), i.e. Color::getHexRGB()
+    const __m256i to_index = _mm256_setr_epi8(
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128,
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    const int* table = reinterpret_cast<const int*>(lut);
+
+    Color* px = begin;
+    for (; end - px >= 8; px += 8) {
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px));
+        const __m256i mapped = _mm256_i32gather_epi32(table, _mm256_shuffle_epi8(src, to_index), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px), _mm256_blendv_epi8(mapped, src, alpha_mask));
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+/// \brief AVX2 version of \c remapPixelsScalar for compact caches, 8 pixels per gather
+LUTOOLS_TARGET("avx2") inline void remapPixelsAvx2(Color* begin, Color* end, const ColorRGB* lut) noexcept {
+    const __m256i to_index = _mm256_setr_epi8(
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128,
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    const int* table = reinterpret_cast<const int*>(lut);
+
+    Color* px = begin;
+    for (; end - px >= 8; px += 8) {
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px));
+        const __m256i index = _mm256_shuffle_epi8(src, to_index);
+        // Byte offset is 3 x index; each gather also grabs the next entry's R, which the blend throws away
+        const __m256i offset = _mm256_add_epi32(index, _mm256_slli_epi32(index, 1));
+        const __m256i mapped = _mm256_i32gather_epi32(table, offset, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px), _mm256_blendv_epi8(mapped, src, alpha_mask));
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+/// \brief AVX2 version of \c remapPixelsScalar for packed RGB pixels, 8 pixels per gather
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+template <typename EntryTy>
+LUTOOLS_TARGET("avx2") void remapPixelsAvx2(ColorRGB* begin, ColorRGB* end, const EntryTy* lut) noexcept {
+    // Lane 0 gets pixels 0-3 (bytes 0-11), lane 1 pixels 4-7 (bytes 12-23)
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i to_index = _mm256_setr_epi8(
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128,
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    // And back: 4 mapped (r, g, b, x) per lane become 12 bytes, then the lanes are joined
+    const __m256i to_rgb = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128);
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    const int* table = reinterpret_cast<const int*>(lut);
+
+    ColorRGB* px = begin;
+    // Each step loads 32 bytes but only consumes 24, so stop while 8 spare bytes remain
+    for (; end - px >= 11; px += 8) {
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(px);
+        const __m256i src = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes)), spread);
+        const __m256i index = _mm256_shuffle_epi8(src, to_index);
+        __m256i mapped;
+        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+            mapped = _mm256_i32gather_epi32(table, _mm256_add_epi32(index, _mm256_slli_epi32(index, 1)), 1);
+        } else {
+            mapped = _mm256_i32gather_epi32(table, index, 4);
+        }
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(mapped, to_rgb), join);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm256_castsi256_si128(packed));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes + 16), _mm256_extracti128_si256(packed, 1));
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+/// \brief \c blendChannel on 32 bytes at once
+/// \param original_weight 256 - weight in every 16-bit lane
+/// \param mapped_weight Weight in every 16-bit lane
+LUTOOLS_TARGET("avx2") inline __m256i blendBytesAvx2(__m256i original, __m256i mapped, __m256i original_weight, __m256i mapped_weight) noexcept {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_set1_epi16(128);
+    // Widened to 16 bits, the sum tops out at 255 x 256 + 128, no overflow
+    const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(original, zero), original_weight),
+        _mm256_mullo_epi16(_mm256_unpacklo_epi8(mapped, zero), mapped_weight)), half), 8);
+    const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(original, zero), original_weight),
+        _mm256_mullo_epi16(_mm256_unpackhi_epi8(mapped, zero), mapped_weight)), half), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+/// \brief AVX2 version of \c blendPixelsScalar, 8 pixels per gather, blended before they are stored
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+template <typename EntryTy>
+LUTOOLS_TARGET("avx2") void blendPixelsAvx2(Color* begin, Color* end, const EntryTy* lut, unsigned weight) noexcept {
+    const __m256i to_index = _mm256_setr_epi8(
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128,
+        2, 1, 0, -128, 6, 5, 4, -128, 10, 9, 8, -128, 14, 13, 12, -128);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    const __m256i original_weight = _mm256_set1_epi16(static_cast<short>(256 - weight));
+    const __m256i mapped_weight = _mm256_set1_epi16(static_cast<short>(weight));
+    const int* table = reinterpret_cast<const int*>(lut);
+
+    Color* px = begin;
+    for (; end - px >= 8; px += 8) {
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px));
+        const __m256i index = _mm256_shuffle_epi8(src, to_index);
+        __m256i mapped;
+        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+            mapped = _mm256_i32gather_epi32(table, _mm256_add_epi32(index, _mm256_slli_epi32(index, 1)), 1);
+        } else {
+            mapped = _mm256_i32gather_epi32(table, index, 4);
+        }
+        const __m256i blended = blendBytesAvx2(src, mapped, original_weight, mapped_weight);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px), _mm256_blendv_epi8(blended, src, alpha_mask));
+    }
+    blendPixelsScalar(px, end, lut, weight);
+}
+
+/// \brief AVX2 version of \c blendPixelsScalar for packed RGB pixels, 8 pixels per gather, blended before they are stored
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+template <typename EntryTy>
+LUTOOLS_TARGET("avx2") void blendPixelsAvx2(ColorRGB* begin, ColorRGB* end, const EntryTy* lut, unsigned weight) noexcept {
+    // Same shuffles as remapPixelsAvx2, plus spreading the source pixels to (r, g, b, x) to line up with the mapped ones
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+    const __m256i to_index = _mm256_setr_epi8(
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128,
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const __m256i to_rgbx = _mm256_setr_epi8(
+        0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128,
+        0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+    const __m256i to_rgb = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -128, -128, -128, -128);
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    const __m256i original_weight = _mm256_set1_epi16(static_cast<short>(256 - weight));
+    const __m256i mapped_weight = _mm256_set1_epi16(static_cast<short>(weight));
+    const int* table = reinterpret_cast<const int*>(lut);
+
+    ColorRGB* px = begin;
+    for (; end - px >= 11; px += 8) {
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(px);
+        const __m256i src = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes)), spread);
+        const __m256i index = _mm256_shuffle_epi8(src, to_index);
+        __m256i mapped;
+        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+            mapped = _mm256_i32gather_epi32(table, _mm256_add_epi32(index, _mm256_slli_epi32(index, 1)), 1);
+        } else {
+            mapped = _mm256_i32gather_epi32(table, index, 4);
+        }
+        const __m256i blended = blendBytesAvx2(_mm256_shuffle_epi8(src, to_rgbx), mapped, original_weight, mapped_weight);
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(blended, to_rgb), join);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm256_castsi256_si128(packed));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes + 16), _mm256_extracti128_si256(packed, 1));
+    }
+    blendPixelsScalar(px, end, lut, weight);
+}
+
+/// \brief Computes Color::getHexRGB() of 16 pixels at once
+LUTOOLS_TARGET("avx512f") inline __m512i getHexRGBAvx512(__m512i src) noexcept {
+    const __m512i byte_mask = _mm512_set1_epi32(0xff);
+    const __m512i g_mask = _mm512_set1_epi32(0xff00);
+    return _mm512_or_si512(
+        _mm512_or_si512(
+            _mm512_slli_epi32(_mm512_and_si512(src, byte_mask), 16),
+            _mm512_and_si512(src, g_mask)),
+        _mm512_and_si512(_mm512_srli_epi32(src, 16), byte_mask));
+}
+
+/// \brief AVX-512 version of \c remapPixelsScalar, 16 pixels per gather
+LUTOOLS_TARGET("avx512f") inline void remapPixelsAvx512(Color* begin, Color* end, const Color* lut) noexcept {
+    const __m512i alpha_mask = _mm512_set1_epi32(static_cast<int>(0xff000000u));
+
+    Color* px = begin;
+    for (; end - px >= 16; px += 16) {
+        const __m512i src = _mm512_loadu_si512(px);
+        const __m512i mapped = _mm512_i32gather_epi32(getHexRGBAvx512(src), lut, 4);
+        _mm512_storeu_si512(px, _mm512_ternarylogic_epi32(alpha_mask, src, mapped, 0xca)); // alpha_mask ? src : mapped
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+/// \brief AVX-512 version of \c remapPixelsScalar for compact caches, 16 pixels per gather
+LUTOOLS_TARGET("avx512f") inline void remapPixelsAvx512(Color* begin, Color* end, const ColorRGB* lut) noexcept {
+    const __m512i alpha_mask = _mm512_set1_epi32(static_cast<int>(0xff000000u));
+
+    Color* px = begin;
+    for (; end - px >= 16; px += 16) {
+        const __m512i src = _mm512_loadu_si512(px);
+        const __m512i index = getHexRGBAvx512(src);
+        const __m512i offset = _mm512_add_epi32(index, _mm512_slli_epi32(index, 1));
+        const __m512i mapped = _mm512_i32gather_epi32(offset, lut, 1);
+        _mm512_storeu_si512(px, _mm512_ternarylogic_epi32(alpha_mask, src, mapped, 0xca));
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+#endif // LUTOOLS_X86
+
+/// \brief Signature shared by all versions of the remap kernel
+/// \tparam EntryTy Entry type of the LUT cache, \c Color or \c ColorRGB
+/// \tparam PixelTy Pixel type of the image, \c Color or packed \c ColorRGB
+template <typename EntryTy, typename PixelTy = Color>
+using RemapKernel = void (*)(PixelTy* begin, PixelTy* end, const EntryTy* lut) noexcept;
+
+/// \brief Picks the fastest remap kernel for the level of \c getCpuLevel
+template <typename EntryTy, typename PixelTy = Color>
+RemapKernel<EntryTy, PixelTy> selectRemapKernel() noexcept {
+#if defined(LUTOOLS_X86)
+    const CpuLevel level = getCpuLevel();
+    if constexpr (std::is_same_v<PixelTy, Color>) {
+        if (level >= CpuLevel::Avx512) {
+            return remapPixelsAvx512;
+        }
+    }
+    if (level >= CpuLevel::Avx2) {
+        return remapPixelsAvx2;
+    }
+#endif
+    return remapPixelsScalar;
+}
+
+/// \brief Replaces every pixel in [begin, end) with its mapped value, keeping the original alpha if any
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \remark The kernel is chosen on first call by runtime CPU detection
+template <typename PixelTy, typename EntryTy>
+void remapPixels(PixelTy* begin, PixelTy* end, const EntryTy* lut) noexcept {
+    static const RemapKernel<EntryTy, PixelTy> kernel = selectRemapKernel<EntryTy, PixelTy>();
+    kernel(begin, end, lut);
+}
+
+/// \brief Signature shared by all versions of the blending remap kernel
+/// \tparam EntryTy Entry type of the LUT cache, \c Color or \c ColorRGB
+/// \tparam PixelTy Pixel type of the image, \c Color or packed \c ColorRGB
+template <typename EntryTy, typename PixelTy = Color>
+using BlendKernel = void (*)(PixelTy* begin, PixelTy* end, const EntryTy* lut, unsigned weight) noexcept;
+
+/// \brief Picks the fastest blending remap kernel for the level of \c getCpuLevel
+template <typename EntryTy, typename PixelTy = Color>
+BlendKernel<EntryTy, PixelTy> selectBlendKernel() noexcept {
+#if defined(LUTOOLS_X86)
+    if (getCpuLevel() >= CpuLevel::Avx2) {
+        return blendPixelsAvx2<EntryTy>;
+    }
+#endif
+    return blendPixelsScalar<EntryTy>;
+}
+
+/// \brief Replaces every pixel in [begin, end) with a blend of itself and its mapped value, keeping the original alpha if any
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param strength Weight of the mapped value, from 0 to 1, in 1/256 steps
+/// \remark The blend happens in the same pass as the lookup; the kernel is chosen on first call by runtime CPU detection
+template <typename PixelTy, typename EntryTy>
+void remapPixels(PixelTy* begin, PixelTy* end, const EntryTy* lut, float strength) noexcept {
+    const unsigned weight = getBlendWeight(strength);
+    if (weight == 256) {
+        remapPixels(begin, end, lut);
+    } else if (weight) {
+        static const BlendKernel<EntryTy, PixelTy> kernel = selectBlendKernel<EntryTy, PixelTy>();
+        kernel(begin, end, lut, weight);
+    }
+}
+
+/// \brief Applies a LUT to a range of pixels, split into stripes of \c APPLY_STRIPE_PIXELS across a thread pool
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param pool The pool to spread the stripes across; runs on the calling thread if \c nullptr
+template <typename PixelTy, typename EntryTy>
+void applyLUT(PixelTy* begin, PixelTy* end, const EntryTy* lut, ThreadPool* pool = nullptr) {
+    parallelFor(pool, 0, static_cast<std::size_t>(end - begin), APPLY_STRIPE_PIXELS, [=](std::size_t first, std::size_t last) {
+        remapPixels(begin + first, begin + last, lut);
+    });
+}
+
+/// \brief Applies a LUT to an entire image in-place
+/// \param img The image
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+template <typename EntryTy>
+void applyLUT(Image& img, const EntryTy* lut, ThreadPool* pool = nullptr) {
+    applyLUT(img.begin(), img.end(), lut, pool);
+}
+
+/// \brief Applies a LUT to a range of pixels, split into stripes of \c APPLY_STRIPE_PIXELS across a thread pool
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut View of a LUT cache of any layout, generally returned by \c mapCacheFile
+/// \param pool The pool to spread the stripes across; runs on the calling thread if \c nullptr
+template <typename PixelTy>
+void applyLUT(PixelTy* begin, PixelTy* end, const LutView& lut, ThreadPool* pool = nullptr) {
+    lut.visit([&](const auto* table) { applyLUT(begin, end, table, pool); });
+}
+
+/// \brief Applies a LUT to an entire image in-place
+/// \param img The image
+/// \param lut View of a LUT cache of any layout, generally returned by \c mapCacheFile
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+inline void applyLUT(Image& img, const LutView& lut, ThreadPool* pool = nullptr) {
+    applyLUT(img.begin(), img.end(), lut, pool);
+}
+
+/// \brief Applies a LUT at partial strength to a range of pixels, split into stripes of \c APPLY_STRIPE_PIXELS across
+/// a thread pool
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut LUT data cache of either \c Color or \c ColorRGB
+/// \param strength Weight of the mapped value against the original one, from 0 to 1
+/// \param pool The pool to spread the stripes across; runs on the calling thread if \c nullptr
+/// \remark To apply one strength to many images, baking it into the LUT with \c blendLUT saves blending every pixel
+template <typename PixelTy, typename EntryTy>
+void applyLUT(PixelTy* begin, PixelTy* end, const EntryTy* lut, float strength, ThreadPool* pool = nullptr) {
+    parallelFor(pool, 0, static_cast<std::size_t>(end - begin), APPLY_STRIPE_PIXELS, [=](std::size_t first, std::size_t last) {
+        remapPixels(begin + first, begin + last, lut, strength);
+    });
+}
+
+/// \brief Applies a LUT at partial strength to a range of pixels, split into stripes of \c APPLY_STRIPE_PIXELS across
+/// a thread pool
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param lut View of a LUT cache of any layout, generally returned by \c mapCacheFile
+/// \param strength Weight of the mapped value against the original one, from 0 to 1
+/// \param pool The pool to spread the stripes across; runs on the calling thread if \c nullptr
+template <typename PixelTy>
+void applyLUT(PixelTy* begin, PixelTy* end, const LutView& lut, float strength, ThreadPool* pool = nullptr) {
+    lut.visit([&](const auto* table) { applyLUT(begin, end, table, strength, pool); });
+}
+
+/// \brief Applies a LUT at partial strength to an entire image in-place
+/// \param img The image
+/// \param lut View of a LUT cache of any layout, generally returned by \c mapCacheFile
+/// \param strength Weight of the mapped value against the original one, from 0 to 1
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+inline void applyLUT(Image& img, const LutView& lut, float strength, ThreadPool* pool = nullptr) {
+    applyLUT(img.begin(), img.end(), lut, strength, pool);
+}
+}
+
+#endif // _APPLY_HPP_
@@ -3,10 +3,23 @@
 #ifndef _COLOR_HPP_
 #define _COLOR_HPP_
 
+#include <functional>
 #include <type_traits>
 
 namespace Lutools {
 
+/// \brief POD class of a specific RGB color, packed into 3 bytes, used as the entry of compact LUT caches
+struct ColorRGB {
+    /// \brief 8-bit quantized value on the R channel
+    unsigned char r;
+    /// \brief 8-bit quantized value on the G channel
+    unsigned char g;
+    /// \brief 8-bit quantized value on the B channel
+    unsigned char b;
+};
+
+static_assert(sizeof(ColorRGB) == 3, "ColorRGB must be tightly packed");
+
 /// \brief POD class of a specific RGBA color
 /// \example
 /// To construct, simply use the uniform Initialization syntax:
@@ -44,6 +57,11 @@ struct Color {
         return *reinterpret_cast<const unsigned int*>(this);
     }
 
+    /// \brief Returns the color without its alpha channel
+    ColorRGB getRGB() const noexcept {
+        return { r, g, b };
+    }
+
     /// \brief Returns the RGB hashcode value of the color, like the one you'll get from e.g. Photoshop, but numeric
     unsigned int getHexRGB() const noexcept {
         return (r << 16) | (g << 8) | b;
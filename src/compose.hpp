@@ -0,0 +1,112 @@
+// Created: 2026-10-16
+
+#ifndef _COMPOSE_HPP_
+#define _COMPOSE_HPP_
+
+#include "apply.hpp"
+#include "color.hpp"
+#include "lut.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Bakes a chain of LUTs, applied one after another, into a single LUT cache
+/// \details The first cache is copied, then remapped through each of the following ones like an image of 16.7M pixels
+/// would be, so entry \c i ends up as <tt>lut_c[lut_b[lut_a[i]]]</tt>. Applying the result takes one lookup per pixel
+/// however long the chain is.
+/// \tparam EntryTy \c Color for a plain RGBA cache, or \c ColorRGB for a compact one
+/// \param chain The LUTs in the order they apply
+/// \param output_file Path of the output (.lut format); writing is skipped if empty
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \param compression How to store the output, see \c saveCacheToFile
+/// \return A table of \c LUT_ENTRY_COUNT \c EntryTy, just like the one returned by \c cacheLUTMap
+/// \remark Ensures a valid table of \c EntryTy
+template <typename EntryTy = Color>
+[[nodiscard]] LutTable<EntryTy> composeLUTs(
+    const std::vector<LutView>& chain,
+    const std::string& output_file,
+    ThreadPool* pool = nullptr,
+    LutCompression compression = LutCompression::None) {
+    if (chain.empty()) {
+        throw std::invalid_argument { "no LUT to compose" };
+    }
+
+    LutTable<EntryTy> result = allocateLutTable<EntryTy>();
+    EntryTy* const data = result.data();
+
+    // Start off with a copy of the first LUT in our own layout
+    chain.front().visit([&](const auto* table) {
+        parallelFor(pool, 0, LUT_RAW_DATA_SIZE, APPLY_STRIPE_PIXELS, [=](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                if constexpr (std::is_same_v<EntryTy, Color>) {
+                    data[i] = { table[i].r, table[i].g, table[i].b, 255 };
+                } else {
+                    data[i] = { table[i].r, table[i].g, table[i].b };
+                }
+            }
+        });
+    });
+
+    // Then send every entry through the rest of the chain, the spare entry of a compact cache stays untouched
+    for (std::size_t i = 1; i < chain.size(); ++i) {
+        applyLUT(data, data + LUT_RAW_DATA_SIZE, chain[i], pool);
+    }
+
+    // Write lut file if output path is given
+    if (!output_file.empty()) {
+        saveCacheToFile(data, output_file, pool, nullptr, compression);
+    }
+    return result;
+}
+
+/// \brief Bakes a LUT at partial strength into a LUT cache, so that applying it blends every pixel with its original value
+/// \details Blending goes through the same kernels as <tt>applyLUT(begin, end, lut, strength, pool)</tt>, run on every
+/// color, so both ways give the same result. Baking costs about as much as blending a 16-megapixel image on the fly.
+/// \tparam EntryTy \c Color for a plain RGBA cache, or \c ColorRGB for a compact one
+/// \param lut The LUT at full strength
+/// \param strength Weight of the mapped value against the original one, from 0 to 1
+/// \param output_file Path of the output (.lut format); writing is skipped if empty
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \param compression How to store the output, see \c saveCacheToFile
+/// \return A table of \c LUT_ENTRY_COUNT \c EntryTy, just like the one returned by \c cacheLUTMap
+/// \remark Ensures a valid table of \c EntryTy
+template <typename EntryTy = Color>
+[[nodiscard]] LutTable<EntryTy> blendLUT(
+    const LutView& lut,
+    float strength,
+    const std::string& output_file,
+    ThreadPool* pool = nullptr,
+    LutCompression compression = LutCompression::None) {
+    LutTable<EntryTy> result = allocateLutTable<EntryTy>();
+    EntryTy* const data = result.data();
+
+    // Start off with the identity, then blend it through the LUT
+    parallelFor(pool, 0, LUT_RAW_DATA_SIZE, APPLY_STRIPE_PIXELS, [=](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            const auto r = static_cast<unsigned char>(i >> 16);
+            const auto g = static_cast<unsigned char>(i >> 8);
+            const auto b = static_cast<unsigned char>(i);
+            if constexpr (std::is_same_v<EntryTy, Color>) {
+                data[i] = { r, g, b, 255 };
+            } else {
+                data[i] = { r, g, b };
+            }
+        }
+    });
+    applyLUT(data, data + LUT_RAW_DATA_SIZE, lut, strength, pool);
+
+    // Write lut file if output path is given
+    if (!output_file.empty()) {
+        saveCacheToFile(data, output_file, pool, nullptr, compression);
+    }
+    return result;
+}
+}
+
+#endif // _COMPOSE_HPP_
@@ -0,0 +1,180 @@
+// Created: 2026-10-16
+
+#ifndef _CPU_HPP_
+#define _CPU_HPP_
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LUTOOLS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// Lets a single function use an instruction set beyond the build's baseline, the caller must check the CPU first
+#if defined(__GNUC__) || defined(__clang__)
+#define LUTOOLS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LUTOOLS_TARGET(isa)
+#endif
+
+// Forces the body of a multiversioned kernel into each of its per-level clones, which compiles it for the clone's
+// instruction set; a callee without a target may be inlined into any clone
+#if defined(_MSC_VER) && !defined(__clang__)
+#define LUTOOLS_KERNEL_BODY __forceinline
+#else
+#define LUTOOLS_KERNEL_BODY inline __attribute__((always_inline))
+#endif
+
+// Targets of the clones of each level, which elsewhere than on x86 are merely copies of the baseline
+#if defined(LUTOOLS_X86) && defined(__GNUC__) && !defined(__clang__)
+// GCC tunes AVX-512 code for 256-bit vectors unless told otherwise
+#define LUTOOLS_TARGET_AVX2 LUTOOLS_TARGET("avx2")
+#define LUTOOLS_TARGET_AVX512 LUTOOLS_TARGET("avx512f,avx512bw,prefer-vector-width=512")
+#elif defined(LUTOOLS_X86)
+#define LUTOOLS_TARGET_AVX2 LUTOOLS_TARGET("avx2")
+#define LUTOOLS_TARGET_AVX512 LUTOOLS_TARGET("avx512f,avx512bw")
+#else
+#define LUTOOLS_TARGET_AVX2
+#define LUTOOLS_TARGET_AVX512
+#endif
+
+namespace Lutools {
+
+/// \brief Instruction set extensions available on the running CPU (and enabled by the OS)
+struct CpuFeatures {
+    bool sse2;
+    bool sse41;
+    bool avx2;
+    bool fma;
+    bool avx512f;
+    bool avx512bw;
+};
+
+/// \brief Queries the running CPU, prefer \c getCpuFeatures() which caches the result
+inline CpuFeatures detectCpuFeatures() noexcept {
+    CpuFeatures features {};
+#if defined(LUTOOLS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    features.sse2 = info[3] & (1 << 26);
+    features.sse41 = info[2] & (1 << 19);
+    const bool os_saves_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+    const unsigned long long xcr0 = os_saves_avx ? _xgetbv(0) : 0;
+    const bool ymm_enabled = (xcr0 & 0x06) == 0x06;
+    const bool zmm_enabled = (xcr0 & 0xe6) == 0xe6;
+    features.fma = ymm_enabled && (info[2] & (1 << 12));
+
+    if (max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        features.avx2 = ymm_enabled && (info[1] & (1 << 5));
+        features.avx512f = zmm_enabled && (info[1] & (1 << 16));
+        features.avx512bw = zmm_enabled && (info[1] & (1 << 30));
+    }
+#else
+    // These also check the OS support of the wider registers
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.fma = __builtin_cpu_supports("fma");
+    features.avx512f = __builtin_cpu_supports("avx512f");
+    features.avx512bw = __builtin_cpu_supports("avx512bw");
+#endif
+#endif
+    return features;
+}
+
+/// \brief Returns the instruction set extensions of the running CPU, detected once per process
+inline const CpuFeatures& getCpuFeatures() noexcept {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+/// \brief Tiers of kernels, each one requiring the previous ones
+enum class CpuLevel : unsigned char {
+    /// \brief Portable kernels, vectorized with SSE2 on x86-64 as the build targets no more
+    Baseline,
+    /// \brief AVX2 kernels
+    Avx2,
+    /// \brief AVX-512 kernels, using the F and BW subsets
+    Avx512
+};
+
+/// \brief Returns the name of a level, as \c LUTOOLS_CPU takes it
+inline const char* getCpuLevelName(CpuLevel level) noexcept {
+    switch (level) {
+    case CpuLevel::Avx512:
+        return "avx512";
+    case CpuLevel::Avx2:
+        return "avx2";
+    default:
+#if defined(LUTOOLS_X86)
+        return "sse2";
+#else
+        return "portable";
+#endif
+    }
+}
+
+/// \brief Returns the highest level of the given features
+inline CpuLevel getSupportedCpuLevel(const CpuFeatures& features) noexcept {
+#if defined(LUTOOLS_X86)
+    if (features.avx2 && features.avx512f && features.avx512bw) {
+        return CpuLevel::Avx512;
+    }
+    if (features.avx2) {
+        return CpuLevel::Avx2;
+    }
+#endif
+    static_cast<void>(features);
+    return CpuLevel::Baseline;
+}
+
+/// \brief Returns the level of the kernels to run, chosen once per process
+/// \details That is the highest level the running CPU supports, unless the \c LUTOOLS_CPU environment variable names a
+/// lower one (see \c getCpuLevelName, e.g. \c sse2 or \c avx2), which lets every version be run on a single host.
+/// Every kernel picks its version from this level on first call.
+inline CpuLevel getCpuLevel() noexcept {
+    static const CpuLevel level = [] {
+        const CpuLevel supported = getSupportedCpuLevel(getCpuFeatures());
+        const char* requested = std::getenv("LUTOOLS_CPU");
+        if (!requested) {
+            return supported;
+        }
+        for (const CpuLevel candidate : { CpuLevel::Baseline, CpuLevel::Avx2, CpuLevel::Avx512 }) {
+            if (std::strcmp(requested, getCpuLevelName(candidate)) == 0) {
+                return std::min(candidate, supported);
+            }
+        }
+        return supported;
+    }();
+    return level;
+}
+
+/// \brief Picks the version of a multiversioned kernel matching \c getCpuLevel
+/// \details A multiversioned kernel is a \c LUTOOLS_KERNEL_BODY function wrapped by a clone per level, a plain one and
+/// ones marked \c LUTOOLS_TARGET_AVX2 and \c LUTOOLS_TARGET_AVX512, so the compiler vectorizes the same code for each
+/// instruction set while the build itself targets the baseline only.
+template <typename KernelTy>
+KernelTy selectKernel(KernelTy baseline, KernelTy avx2, KernelTy avx512) noexcept {
+    switch (getCpuLevel()) {
+    case CpuLevel::Avx512:
+        return avx512;
+    case CpuLevel::Avx2:
+        return avx2;
+    default:
+        return baseline;
+    }
+}
+}
+
+#endif // _CPU_HPP_
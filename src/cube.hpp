@@ -3,18 +3,52 @@
 #ifndef _CUBE_HPP_
 #define _CUBE_HPP_
 
+#include "lattice.hpp"
 #include "lut.hpp"
+#include "mapped_file.hpp"
 #include "pathutils.hpp"
+#include "thread_pool.hpp"
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <string>
+#include <vector>
 
 namespace Lutools {
 
+/// \brief Length of a formatted channel value in a cube file, e.g. "0.498039"
+inline static constexpr std::size_t CUBE_VALUE_LENGTH = 8;
+
+/// \brief Size of the buffer lines are formatted into before they are written out
+inline static constexpr std::size_t CUBE_WRITE_BUFFER_SIZE = static_cast<std::size_t>(1) << 22;
+
+/// \brief Returns all 256 possible channel values of a cube file, each formatted with 6-digit fixed precision
+/// \remark An 8-bit value \c v is written as \c v / 255, so there's no need to format a double more than 256 times
+inline const std::array<std::array<char, CUBE_VALUE_LENGTH>, 256>& getCubeValueStrings() {
+    static const auto strings = [] {
+        std::array<std::array<char, CUBE_VALUE_LENGTH>, 256> result {};
+        constexpr double quantization_factor = 1. / 255.;
+        for (int v = 0; v < 256; ++v) {
+            char formatted[16];
+            std::snprintf(formatted, sizeof(formatted), "%.6f", v * quantization_factor);
+            std::memcpy(result[v].data(), formatted, CUBE_VALUE_LENGTH);
+        }
+        return result;
+    }();
+    return strings;
+}
+
 /// \brief Cube file (.cube) exporter
-/// \param data LUT data cache, generally returned by \c cacheLUTMap or \c loadCacheFromFile
+/// \param data LUT data cache of either \c Color or \c ColorRGB, generally returned by \c cacheLUTMap or \c loadCacheFromFile
 /// \param cube_res The desired LUT resolution, should be greater than 1, of course
 /// \param output_file Path of the output
-inline void generateCube(const Color* data, int cube_res, const std::string& output_file) {
+template <typename EntryTy>
+void generateCube(const EntryTy* data, int cube_res, const std::string& output_file) {
     std::ofstream fout;
     fout.open(output_file, std::ofstream::trunc);
     if (!fout.is_open()) {
@@ -24,29 +58,442 @@ inline void generateCube(const Color* data, int cube_res, const std::string& out
     fout << "TITLE " << Pathutils::getBaseName(output_file) << '\n';
     fout << "LUT_3D_SIZE " << cube_res << "\n\n";
 
-    // 6-digit fixed precision
-    fout.precision(6);
-    fout << std::fixed;
+    // Lines are pasted together from preformatted values, and written out a large buffer at a time
+    const auto& value_strings = getCubeValueStrings();
+    constexpr std::size_t line_length = CUBE_VALUE_LENGTH * 3 + 3;
+    std::vector<char> buffer(CUBE_WRITE_BUFFER_SIZE / line_length * line_length);
+    char* cursor = buffer.data();
+    char* const buffer_end = buffer.data() + buffer.size();
 
     const auto sample_points = sampleSpan(0, 255, cube_res);
     for (int b_index = 0; b_index < cube_res; ++b_index) {
         for (int g_index = 0; g_index < cube_res; ++g_index) {
             for (int r_index = 0; r_index < cube_res; ++r_index) {
-                Color rgba {
+                const Color rgba {
                     static_cast<unsigned char>(sample_points[r_index]),
                     static_cast<unsigned char>(sample_points[g_index]),
                     static_cast<unsigned char>(sample_points[b_index]),
                     255
                 };
+                const EntryTy& mapped = data[rgba.getHexRGB()];
+
+                std::memcpy(cursor, value_strings[mapped.r].data(), CUBE_VALUE_LENGTH);
+                cursor[CUBE_VALUE_LENGTH] = ' ';
+                std::memcpy(cursor + CUBE_VALUE_LENGTH + 1, value_strings[mapped.g].data(), CUBE_VALUE_LENGTH);
+                cursor[CUBE_VALUE_LENGTH * 2 + 1] = ' ';
+                std::memcpy(cursor + CUBE_VALUE_LENGTH * 2 + 2, value_strings[mapped.b].data(), CUBE_VALUE_LENGTH);
+                cursor[CUBE_VALUE_LENGTH * 3 + 2] = '\n';
+                cursor += line_length;
+
+                if (cursor == buffer_end) {
+                    fout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    cursor = buffer.data();
+                }
+            }
+        }
+    }
+    fout.write(buffer.data(), static_cast<std::streamsize>(cursor - buffer.data()));
+
+    fout.close();
+    if (fout.fail()) {
+        throw std::runtime_error { "failed to write cube file" };
+    }
+}
+
+/// \brief Cube file (.cube) exporter
+/// \param data View of a LUT cache of any layout, generally returned by \c mapCacheFile
+/// \param cube_res The desired LUT resolution, should be greater than 1, of course
+/// \param output_file Path of the output
+inline void generateCube(const LutView& data, int cube_res, const std::string& output_file) {
+    data.visit([&](const auto* table) { generateCube(table, cube_res, output_file); });
+}
+
+/// \brief Converts a channel value of a cube file to 8 bits, clamping it into [0, 1]
+inline unsigned char quantizeCubeValue(float value) noexcept {
+    return static_cast<unsigned char>(std::min(std::max(value, 0.f), 1.f) * 255.f + .5f);
+}
+
+/// \brief Interpolates 256 LUT cache entries along B from a row of cube nodes, which is the last pass of the trilinear fill; portable version
+/// \param row RGB triplets of the nodes along B
+/// \param cells Index of the lower node of the cell containing each 8-bit B value
+/// \param weights How far each 8-bit B value is from the lower node towards the upper one
+/// \param out The 256 entries to be filled
+template <typename EntryTy>
+void fillCubeRowScalar(const float* row, const int* cells, const float* weights, EntryTy* out) noexcept {
+    for (int b = 0; b < 256; ++b) {
+        const float fb = weights[b];
+        const float* node = row + cells[b] * 3;
+        const unsigned char mapped_r = quantizeCubeValue(node[0] + (node[3] - node[0]) * fb);
+        const unsigned char mapped_g = quantizeCubeValue(node[1] + (node[4] - node[1]) * fb);
+        const unsigned char mapped_b = quantizeCubeValue(node[2] + (node[5] - node[2]) * fb);
+        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+            out[b] = { mapped_r, mapped_g, mapped_b };
+        } else {
+            out[b] = { mapped_r, mapped_g, mapped_b, 255 };
+        }
+    }
+}
+
+#if defined(LUTOOLS_X86)
+
+/// \brief Interpolates 8 values of a channel of cube nodes, quantized to 8 bits
+LUTOOLS_TARGET("avx2") inline __m256i lerpCubeChannelAvx2(const float* row, __m256i offsets, __m256 weights) noexcept {
+    const __m256 lower = _mm256_i32gather_ps(row, offsets, 4);
+    const __m256 upper = _mm256_i32gather_ps(row + 3, offsets, 4);
+    // Multiplies and adds stay separate, so results are identical to the portable version
+    const __m256 value = _mm256_add_ps(lower, _mm256_mul_ps(_mm256_sub_ps(upper, lower), weights));
+    const __m256 clamped = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(clamped, _mm256_set1_ps(255.f)), _mm256_set1_ps(.5f)));
+}
+
+/// \brief AVX2 version of \c fillCubeRowScalar, 8 entries at a time
+template <typename EntryTy>
+LUTOOLS_TARGET("avx2") void fillCubeRowAvx2(const float* row, const int* cells, const float* weights, EntryTy* out) noexcept {
+    for (int b = 0; b < 256; b += 8) {
+        const __m256i cell = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + b));
+        const __m256i offsets = _mm256_add_epi32(cell, _mm256_slli_epi32(cell, 1));
+        const __m256 fb = _mm256_loadu_ps(weights + b);
+
+        const __m256i packed = _mm256_or_si256(
+            _mm256_or_si256(
+                lerpCubeChannelAvx2(row, offsets, fb),
+                _mm256_slli_epi32(lerpCubeChannelAvx2(row + 1, offsets, fb), 8)),
+            _mm256_or_si256(
+                _mm256_slli_epi32(lerpCubeChannelAvx2(row + 2, offsets, fb), 16),
+                _mm256_set1_epi32(static_cast<int>(0xff000000u))));
+
+        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+            Color rgba[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba), packed);
+            for (int i = 0; i < 8; ++i) {
+                out[b + i] = rgba[i].getRGB();
+            }
+        } else {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + b), packed);
+        }
+    }
+}
+
+#endif // LUTOOLS_X86
+
+/// \brief Interpolates 256 LUT cache entries along B from a row of cube nodes, which is the last pass of the trilinear fill
+/// \remark The kernel is chosen on first call by runtime CPU detection
+template <typename EntryTy>
+void fillCubeRow(const float* row, const int* cells, const float* weights, EntryTy* out) noexcept {
+    using FillKernel = void (*)(const float*, const int*, const float*, EntryTy*) noexcept;
+    static const FillKernel kernel = [] () -> FillKernel {
+#if defined(LUTOOLS_X86)
+        if (getCpuLevel() >= CpuLevel::Avx2) {
+            return fillCubeRowAvx2<EntryTy>;
+        }
+#endif
+        return fillCubeRowScalar<EntryTy>;
+    }();
+    kernel(row, cells, weights, out);
+}
+
+/// \brief Interpolation used between the nodes of a cube file
+enum class CubeInterpolation : unsigned char {
+    /// \brief Blends the 8 corners of the cell, the default of most grading software
+    Trilinear,
+    /// \brief Blends the 4 corners of the tetrahedron within the cell
+    Tetrahedral
+};
+
+/// \brief A 3D LUT loaded from a cube file (.cube)
+/// \details Supports \c LUT_3D_SIZE, \c DOMAIN_MIN, \c DOMAIN_MAX, \c LUT_3D_INPUT_RANGE and comments; 1D LUTs are rejected
+class CubeLut {
+    int _size = 0;
+    std::array<float, 3> _domain_min { 0.f, 0.f, 0.f };
+    std::array<float, 3> _domain_max { 1.f, 1.f, 1.f };
+
+    /// \brief RGB triplets of all nodes, R index varies fastest, then G, then B
+    std::vector<float> _nodes {};
+
+    /// \brief For each channel (R, G, B) and each 8-bit value: index of the lower node of the cell containing it
+    std::array<std::array<int, 256>, 3> _cells {};
+
+    /// \brief For each channel (R, G, B) and each 8-bit value: how far it is from the lower node towards the upper one
+    std::array<std::array<float, 256>, 3> _weights {};
+
+    static const char* skipBlanks(const char* p, const char* end) noexcept {
+        while (p != end && (*p == ' ' || *p == '\t')) {
+            ++p;
+        }
+        return p;
+    }
 
-                rgba = data[rgba.getHexRGB()];
-                constexpr double quantization_factor = 1. / 255.;
-                fout << rgba.r * quantization_factor << ' '
-                    << rgba.g * quantization_factor << ' '
-                    << rgba.b * quantization_factor << '\n';
+    static const char* parseFloat(const char* p, const char* end, float& value, std::size_t line) {
+        p = skipBlanks(p, end);
+        if (p != end && *p == '+') {
+            ++p;
+        }
+        const auto [next, error] = std::from_chars(p, end, value);
+        // from_chars takes nan and inf, which nothing downstream can quantize or interpolate
+        if (error != std::errc {} || !std::isfinite(value)) {
+            throw std::runtime_error { "invalid number in cube file at line " + std::to_string(line) };
+        }
+        return next;
+    }
+
+    void parse(const char* p, const char* end) {
+        std::size_t parsed = 0;
+        for (std::size_t line = 1; p != end; ++line) {
+            const char* line_end = std::find(p, end, '\n');
+            p = skipBlanks(p, line_end);
+
+            if (p == line_end || *p == '#' || *p == '\r') {
+                // Blank line or comment
+            } else if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.') {
+                // Node
+                if (!_size) {
+                    throw std::runtime_error { "cube file has data before LUT_3D_SIZE" };
+                }
+                if (parsed == _nodes.size()) {
+                    throw std::runtime_error { "cube file has more data than LUT_3D_SIZE implies" };
+                }
+                for (int channel = 0; channel < 3; ++channel) {
+                    p = parseFloat(p, line_end, _nodes[parsed++], line);
+                }
+            } else {
+                // Keyword
+                const char* keyword_end = p;
+                while (keyword_end != line_end && *keyword_end != ' ' && *keyword_end != '\t' && *keyword_end != '\r') {
+                    ++keyword_end;
+                }
+                const std::string keyword { p, keyword_end };
+                p = keyword_end;
+
+                if (keyword == "LUT_3D_SIZE") {
+                    float size;
+                    parseFloat(p, line_end, size, line);
+                    _size = static_cast<int>(size);
+                    if (_size < 2 || _size > 256 || _size != size) {
+                        throw std::runtime_error { "invalid LUT_3D_SIZE in cube file" };
+                    }
+                    _nodes.resize(static_cast<std::size_t>(_size) * _size * _size * 3);
+                } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+                    auto& domain = keyword == "DOMAIN_MIN" ? _domain_min : _domain_max;
+                    for (float& bound: domain) {
+                        p = parseFloat(p, line_end, bound, line);
+                    }
+                } else if (keyword == "LUT_3D_INPUT_RANGE") {
+                    float min;
+                    float max;
+                    p = parseFloat(p, line_end, min, line);
+                    parseFloat(p, line_end, max, line);
+                    _domain_min = { min, min, min };
+                    _domain_max = { max, max, max };
+                } else if (keyword == "LUT_1D_SIZE") {
+                    throw std::runtime_error { "1D cube files are not supported" };
+                }
+                // Others, e.g. TITLE, are irrelevant
+            }
+
+            p = line_end == end ? end : line_end + 1;
+        }
+
+        if (!_size) {
+            throw std::runtime_error { "cube file has no LUT_3D_SIZE" };
+        }
+        if (parsed != _nodes.size()) {
+            throw std::runtime_error { "cube file has less data than LUT_3D_SIZE implies" };
+        }
+    }
+
+    void initCells() {
+        for (int channel = 0; channel < 3; ++channel) {
+            const float span = _domain_max[channel] - _domain_min[channel];
+            if (!(span > 0.f)) {
+                throw std::runtime_error { "invalid domain in cube file" };
+            }
+            for (int v = 0; v < 256; ++v) {
+                const float position = std::clamp((v / 255.f - _domain_min[channel]) / span, 0.f, 1.f) * static_cast<float>(_size - 1);
+                const int cell = std::min(static_cast<int>(position), _size - 2);
+                _cells[channel][v] = cell;
+                _weights[channel][v] = position - static_cast<float>(cell);
+            }
+        }
+    }
+
+    static unsigned char quantize(float value) noexcept {
+        return quantizeCubeValue(value);
+    }
+
+    /// \brief Tetrahedral interpolation inside the cell whose lower node is \c c0
+    void interpolateTetrahedral(const float* c0, float fr, float fg, float fb, float* out) const noexcept {
+        const std::ptrdiff_t dx = 3;
+        const std::ptrdiff_t dy = dx * _size;
+        const std::ptrdiff_t dz = dy * _size;
+
+        // Walk from the lower corner to the upper one along the axes in descending order of weight
+        std::ptrdiff_t first;
+        std::ptrdiff_t second;
+        float hi;
+        float mid;
+        float lo;
+        if (fr >= fg) {
+            if (fg >= fb) {
+                first = dx, second = dx + dy, hi = fr, mid = fg, lo = fb;
+            } else if (fr >= fb) {
+                first = dx, second = dx + dz, hi = fr, mid = fb, lo = fg;
+            } else {
+                first = dz, second = dz + dx, hi = fb, mid = fr, lo = fg;
+            }
+        } else {
+            if (fr >= fb) {
+                first = dy, second = dy + dx, hi = fg, mid = fr, lo = fb;
+            } else if (fg >= fb) {
+                first = dy, second = dy + dz, hi = fg, mid = fb, lo = fr;
+            } else {
+                first = dz, second = dz + dy, hi = fb, mid = fg, lo = fr;
             }
         }
+
+        const float* c1 = c0 + first;
+        const float* c2 = c0 + second;
+        const float* c3 = c0 + dx + dy + dz;
+        for (int channel = 0; channel < 3; ++channel) {
+            out[channel] = c0[channel] * (1.f - hi) + c1[channel] * (hi - mid) + c2[channel] * (mid - lo) + c3[channel] * lo;
+        }
+    }
+
+public:
+    /// \brief Loads a cube file
+    /// \param path Path of the cube file
+    explicit CubeLut(const std::string& path) {
+        const MappedFile file { path };
+        const auto* text = reinterpret_cast<const char*>(file.data());
+        parse(text, text + file.size());
+        initCells();
+    }
+
+    /// \brief Returns the number of nodes along each axis
+    int getSize() const noexcept { return _size; }
+    /// \brief Returns the RGB triplets of all nodes, R index varies fastest, then G, then B
+    const float* getNodes() const noexcept { return _nodes.data(); }
+
+    /// \brief Returns the mapped value of a color, keeping its alpha
+    Color sample(Color color, CubeInterpolation interpolation = CubeInterpolation::Trilinear) const noexcept {
+        const float fr = _weights[0][color.r];
+        const float fg = _weights[1][color.g];
+        const float fb = _weights[2][color.b];
+        const std::ptrdiff_t dx = 3;
+        const std::ptrdiff_t dy = dx * _size;
+        const std::ptrdiff_t dz = dy * _size;
+        const float* c0 = _nodes.data() + _cells[0][color.r] * dx + _cells[1][color.g] * dy + _cells[2][color.b] * dz;
+
+        float mapped[3];
+        if (interpolation == CubeInterpolation::Tetrahedral) {
+            interpolateTetrahedral(c0, fr, fg, fb, mapped);
+        } else {
+            for (int channel = 0; channel < 3; ++channel) {
+                const float* c = c0 + channel;
+                const float c00 = c[0] + (c[dx] - c[0]) * fr;
+                const float c10 = c[dy] + (c[dy + dx] - c[dy]) * fr;
+                const float c01 = c[dz] + (c[dz + dx] - c[dz]) * fr;
+                const float c11 = c[dz + dy] + (c[dz + dy + dx] - c[dz + dy]) * fr;
+                const float c0_ = c00 + (c10 - c00) * fg;
+                const float c1_ = c01 + (c11 - c01) * fg;
+                mapped[channel] = c0_ + (c1_ - c0_) * fb;
+            }
+        }
+        return { quantize(mapped[0]), quantize(mapped[1]), quantize(mapped[2]), color.a };
+    }
+
+    /// \brief Fills a LUT cache with every color of the RGB colorspace mapped by this cube
+    /// \param data LUT data cache of either \c Color or \c ColorRGB to be filled
+    /// \param interpolation Interpolation between the nodes
+    /// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+    /// \remark Work is split along R, the slowest-varying channel of the cache, so every thread writes its own contiguous block.
+    /// The trilinear fill is done one axis at a time: a plane of G x B nodes is interpolated along R,
+    /// then a row of B nodes along G, and finally the 256 entries along B, which leaves a single lerp per channel per entry
+    template <typename EntryTy>
+    void expand(EntryTy* data, CubeInterpolation interpolation = CubeInterpolation::Trilinear, ThreadPool* pool = nullptr) const {
+        const int n = _size;
+        parallelFor(pool, 0, 256, 4, [&](std::size_t first, std::size_t last) {
+            std::vector<float> plane(static_cast<std::size_t>(n) * n * 3);
+            std::vector<float> row(static_cast<std::size_t>(n) * 3);
+
+            for (int r = static_cast<int>(first); r < static_cast<int>(last); ++r) {
+                EntryTy* out = data + (static_cast<std::size_t>(r) << 16);
+
+                if (interpolation == CubeInterpolation::Tetrahedral) {
+                    for (int g = 0; g < 256; ++g) {
+                        for (int b = 0; b < 256; ++b) {
+                            const Color mapped = sample({ static_cast<unsigned char>(r), static_cast<unsigned char>(g), static_cast<unsigned char>(b), 255 },
+                                CubeInterpolation::Tetrahedral);
+                            if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+                                *out++ = mapped.getRGB();
+                            } else {
+                                *out++ = mapped;
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                // Plane of G x B nodes at this R, plane[(b_node * n + g_node) * 3 + channel]
+                const float fr = _weights[0][r];
+                const float* lower = _nodes.data() + _cells[0][r] * 3;
+                for (int i = 0; i < n * n; ++i) {
+                    const float* node = lower + static_cast<std::ptrdiff_t>(i) * n * 3;
+                    for (int channel = 0; channel < 3; ++channel) {
+                        plane[i * 3 + channel] = node[channel] + (node[3 + channel] - node[channel]) * fr;
+                    }
+                }
+
+                for (int g = 0; g < 256; ++g) {
+                    // Row of B nodes at this R and G, row[b_node * 3 + channel]
+                    const float fg = _weights[1][g];
+                    const int g_cell = _cells[1][g];
+                    for (int b_node = 0; b_node < n; ++b_node) {
+                        const float* node = plane.data() + (static_cast<std::ptrdiff_t>(b_node) * n + g_cell) * 3;
+                        for (int channel = 0; channel < 3; ++channel) {
+                            row[b_node * 3 + channel] = node[channel] + (node[3 + channel] - node[channel]) * fg;
+                        }
+                    }
+
+                    fillCubeRow(row.data(), _cells[2].data(), _weights[2].data(), out);
+                    out += 256;
+                }
+            }
+        });
+    }
+
+    /// \brief Resamples this cube into a lattice, without going through a full LUT cache
+    /// \param size Number of nodes along each axis of the lattice
+    LatticeLut toLattice(int size, CubeInterpolation interpolation = CubeInterpolation::Trilinear) const {
+        return LatticeLut::sample(size, [&](Color rgba) { return sample(rgba, interpolation); });
+    }
+};
+
+/// \brief Expands a cube file (.cube) into an entire LUT cache
+/// \tparam EntryTy \c Color for a plain RGBA cache, or \c ColorRGB for a compact one
+/// \param input_file Path of the cube file
+/// \param output_file Path of the output (.lut format); writing is skipped if empty
+/// \param interpolation Interpolation between the nodes of the cube
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \param compression How to store the output, see \c saveCacheToFile
+/// \return A table of \c LUT_ENTRY_COUNT \c EntryTy, just like the one returned by \c cacheLUTMap
+/// \remark Ensures a valid table of \c EntryTy
+template <typename EntryTy = Color>
+[[nodiscard]] LutTable<EntryTy> cacheCubeFile(
+    const std::string& input_file,
+    const std::string& output_file,
+    CubeInterpolation interpolation = CubeInterpolation::Trilinear,
+    ThreadPool* pool = nullptr,
+    LutCompression compression = LutCompression::None) {
+    const CubeLut cube { input_file };
+    LutTable<EntryTy> data = allocateLutTable<EntryTy>();
+    cube.expand(data.data(), interpolation, pool);
+
+    // Write lut file if output path is given, recording the cube file so that a changed one gets the cache rebuilt
+    if (!output_file.empty()) {
+        const LutSource source = getLutSource(input_file, LUT_SOURCE_NO_AXIS, pool);
+        saveCacheToFile(data.data(), output_file, pool, &source, compression);
     }
+    return data;
 }
 }
 
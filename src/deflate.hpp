@@ -0,0 +1,496 @@
+// Created: 2026-10-16
+
+#ifndef _DEFLATE_HPP_
+#define _DEFLATE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Lutools {
+
+#pragma region Checksums
+
+/// \brief Computes the CRC-32 used by PNG chunks and gzip, 8 bytes per step
+/// \param crc CRC of the preceding data, to checksum a stream in pieces
+inline std::uint32_t crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0) noexcept {
+    static const auto tables = [] {
+        std::array<std::array<std::uint32_t, 256>, 8> t {};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][i] = c;
+        }
+        for (std::size_t i = 0; i < 256; ++i) {
+            for (std::size_t s = 1; s < 8; ++s) {
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+            }
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (; size >= 8; data += 8, size -= 8) {
+        const std::uint32_t lo = crc ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<std::uint32_t>(data[3]) << 24);
+        const std::uint32_t hi = data[4] | data[5] << 8 | data[6] << 16 | static_cast<std::uint32_t>(data[7]) << 24;
+        crc = tables[7][lo & 0xff] ^ tables[6][lo >> 8 & 0xff] ^ tables[5][lo >> 16 & 0xff] ^ tables[4][lo >> 24]
+            ^ tables[3][hi & 0xff] ^ tables[2][hi >> 8 & 0xff] ^ tables[1][hi >> 16 & 0xff] ^ tables[0][hi >> 24];
+    }
+    for (; size; ++data, --size) {
+        crc = tables[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/// \brief Modulus of Adler-32
+inline static constexpr std::uint32_t ADLER32_BASE = 65521;
+
+/// \brief Computes the Adler-32 checksum ending a zlib stream
+/// \param adler Checksum of the preceding data, to checksum a stream in pieces
+inline std::uint32_t adler32(const unsigned char* data, std::size_t size, std::uint32_t adler = 1) noexcept {
+    std::uint32_t a = adler & 0xffff;
+    std::uint32_t b = adler >> 16;
+    while (size) {
+        // Largest run before b could overflow 32 bits
+        const std::size_t run = std::min<std::size_t>(size, 5552);
+        for (std::size_t i = 0; i < run; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= ADLER32_BASE;
+        b %= ADLER32_BASE;
+        data += run;
+        size -= run;
+    }
+    return b << 16 | a;
+}
+
+/// \brief Computes the Adler-32 of two consecutive pieces of data from the checksums of each piece
+/// \param size2 Length of the second piece
+inline std::uint32_t adler32Combine(std::uint32_t adler1, std::uint32_t adler2, std::size_t size2) noexcept {
+    const std::uint32_t rem = static_cast<std::uint32_t>(size2 % ADLER32_BASE);
+    std::uint32_t a = adler1 & 0xffff;
+    std::uint32_t b = static_cast<std::uint32_t>(static_cast<std::uint64_t>(rem) * a % ADLER32_BASE);
+    a += (adler2 & 0xffff) + ADLER32_BASE - 1;
+    b += (adler1 >> 16) + (adler2 >> 16) + ADLER32_BASE - rem;
+    a %= ADLER32_BASE;
+    b %= ADLER32_BASE;
+    return b << 16 | a;
+}
+
+#pragma endregion
+
+/// \brief How hard \c DeflateEncoder looks for matches
+enum class DeflateEffort : unsigned char {
+    Fast, ///< Probes one candidate per position and skips over matched data
+    Default, ///< Walks a short hash chain and indexes every position
+};
+
+/// \brief Raw deflate (RFC 1951) compressor emitting dynamic Huffman blocks
+/// \details Each call to \c compress is independent apart from the dictionary it is given, so pieces of one stream
+/// can be compressed in parallel and simply concatenated: every piece but the last ends with a sync flush.
+class DeflateEncoder {
+    inline static constexpr std::size_t WINDOW_SIZE = 32768;
+    inline static constexpr int HASH_BITS = 15;
+    inline static constexpr std::size_t MIN_MATCH = 4; // Hashing 4 bytes, a whole RGBA pixel
+    inline static constexpr std::size_t MAX_MATCH = 258;
+    inline static constexpr std::size_t BLOCK_SYMBOLS = 1 << 16;
+
+    struct Symbol {
+        std::uint16_t value; // Literal byte, or match length
+        std::uint16_t distance; // 0 for literals
+    };
+
+    struct Tables {
+        std::array<unsigned char, MAX_MATCH + 1> length_code {};
+        std::array<unsigned char, 256> distance_code_near {}; // By distance - 1
+        std::array<unsigned char, 256> distance_code_far {}; // By (distance - 1) >> 7
+    };
+
+    inline static constexpr std::array<std::uint16_t, 29> LENGTH_BASE {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    inline static constexpr std::array<unsigned char, 29> LENGTH_EXTRA {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    inline static constexpr std::array<std::uint16_t, 30> DISTANCE_BASE {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    inline static constexpr std::array<unsigned char, 30> DISTANCE_EXTRA {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+    inline static constexpr std::array<unsigned char, 19> CODE_LENGTH_ORDER {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    DeflateEffort _effort;
+    std::vector<std::int32_t> _head;
+    std::vector<std::int32_t> _prev;
+    std::vector<Symbol> _symbols;
+
+    std::vector<unsigned char>* _out = nullptr;
+    std::uint64_t _bit_buffer = 0;
+    int _bit_count = 0;
+
+    static const Tables& getTables() noexcept {
+        static const Tables tables = [] {
+            Tables t {};
+            for (unsigned char code = 0; code < 29; ++code) {
+                for (std::size_t len = LENGTH_BASE[code]; len < LENGTH_BASE[code] + (1u << LENGTH_EXTRA[code]) && len <= MAX_MATCH; ++len) {
+                    t.length_code[len] = code;
+                }
+            }
+            t.length_code[MAX_MATCH] = 28; // 258 has a code of its own, not 227 + 31
+            for (unsigned char code = 0; code < 30; ++code) {
+                for (std::size_t dist = DISTANCE_BASE[code]; dist < DISTANCE_BASE[code] + (1u << DISTANCE_EXTRA[code]); ++dist) {
+                    if (dist <= 256) {
+                        t.distance_code_near[dist - 1] = code;
+                    } else {
+                        t.distance_code_far[(dist - 1) >> 7] = code;
+                    }
+                }
+            }
+            return t;
+        }();
+        return tables;
+    }
+
+    static unsigned getDistanceCode(const Tables& t, unsigned distance) noexcept {
+        return distance <= 256 ? t.distance_code_near[distance - 1] : t.distance_code_far[(distance - 1) >> 7];
+    }
+
+    static std::uint32_t hash(const unsigned char* p) noexcept {
+        std::uint32_t v;
+        std::memcpy(&v, p, 4);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    static std::size_t getMatchLength(const unsigned char* a, const unsigned char* b, std::size_t max_len) noexcept {
+        std::size_t len = 0;
+        for (; len + 8 <= max_len; len += 8) {
+            std::uint64_t x, y;
+            std::memcpy(&x, a + len, 8);
+            std::memcpy(&y, b + len, 8);
+            if (x != y) { break; }
+        }
+        while (len < max_len && a[len] == b[len]) { ++len; }
+        return len;
+    }
+
+    /// \brief Computes code lengths no longer than \c max_bits for the given symbol frequencies
+    static void buildLengths(const std::uint32_t* freq, std::size_t n, int max_bits, unsigned char* lengths) {
+        std::vector<std::uint32_t> f(freq, freq + n);
+        std::vector<std::size_t> order;
+        std::vector<std::uint64_t> weight;
+        std::vector<std::size_t> parent;
+        std::vector<int> depth;
+
+        for (;;) {
+            std::fill(lengths, lengths + n, static_cast<unsigned char>(0));
+            order.clear();
+            for (std::size_t i = 0; i < n; ++i) {
+                if (f[i]) { order.push_back(i); }
+            }
+            const std::size_t m = order.size();
+            if (m == 0) { return; }
+            if (m == 1) {
+                lengths[order[0]] = 1;
+                return;
+            }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return f[a] < f[b]; });
+
+            // Two-queue Huffman: leaves in order, then internal nodes as they are made, both ascending
+            weight.assign(2 * m - 1, 0);
+            parent.assign(2 * m - 1, 0);
+            for (std::size_t i = 0; i < m; ++i) {
+                weight[i] = f[order[i]];
+            }
+            std::size_t leaf = 0;
+            std::size_t inner = m;
+            const auto pick = [&](std::size_t made) {
+                return leaf < m && (inner >= made || weight[leaf] <= weight[inner]) ? leaf++ : inner++;
+            };
+            for (std::size_t made = m; made < 2 * m - 1; ++made) {
+                const std::size_t a = pick(made);
+                const std::size_t b = pick(made);
+                weight[made] = weight[a] + weight[b];
+                parent[a] = parent[b] = made;
+            }
+
+            depth.assign(2 * m - 1, 0);
+            int max_depth = 0;
+            for (std::size_t i = 2 * m - 2; i-- > 0;) {
+                depth[i] = depth[parent[i]] + 1;
+                max_depth = std::max(max_depth, depth[i]);
+            }
+            if (max_depth <= max_bits) {
+                for (std::size_t i = 0; i < m; ++i) {
+                    lengths[order[i]] = static_cast<unsigned char>(depth[i]);
+                }
+                return;
+            }
+
+            // Too deep, flatten the distribution and retry
+            for (std::uint32_t& x : f) {
+                if (x) { x = (x >> 1) | 1; }
+            }
+        }
+    }
+
+    /// \brief Assigns canonical codes to code lengths, bit-reversed as deflate sends them LSB first
+    static void buildCodes(const unsigned char* lengths, std::size_t n, std::uint16_t* codes) noexcept {
+        unsigned count[16] {};
+        for (std::size_t i = 0; i < n; ++i) { ++count[lengths[i]]; }
+        count[0] = 0;
+        unsigned next[16] {};
+        for (int bits = 1, code = 0; bits < 16; ++bits) {
+            code = (code + static_cast<int>(count[bits - 1])) << 1;
+            next[bits] = static_cast<unsigned>(code);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            const int len = lengths[i];
+            if (!len) { continue; }
+            unsigned code = next[len]++;
+            unsigned reversed = 0;
+            for (int k = 0; k < len; ++k) {
+                reversed = (reversed << 1) | (code & 1);
+                code >>= 1;
+            }
+            codes[i] = static_cast<std::uint16_t>(reversed);
+        }
+    }
+
+#pragma region Bit output
+
+    void putBits(std::uint32_t bits, int count) {
+        _bit_buffer |= static_cast<std::uint64_t>(bits) << _bit_count;
+        _bit_count += count;
+        if (_bit_count >= 32) {
+            for (int i = 0; i < 4; ++i) {
+                _out->push_back(static_cast<unsigned char>(_bit_buffer >> (8 * i)));
+            }
+            _bit_buffer >>= 32;
+            _bit_count -= 32;
+        }
+    }
+
+    void alignToByte() {
+        while (_bit_count > 0) {
+            _out->push_back(static_cast<unsigned char>(_bit_buffer));
+            _bit_buffer >>= 8;
+            _bit_count -= 8;
+        }
+        _bit_buffer = 0;
+        _bit_count = 0;
+    }
+
+#pragma endregion
+
+    /// \brief Emits the buffered symbols as one dynamic Huffman block
+    void writeBlock(bool final) {
+        const Tables& t = getTables();
+
+        std::uint32_t lit_freq[286] {};
+        std::uint32_t dist_freq[30] {};
+        for (const Symbol& s : _symbols) {
+            if (s.distance) {
+                ++lit_freq[257 + t.length_code[s.value]];
+                ++dist_freq[getDistanceCode(t, s.distance)];
+            } else {
+                ++lit_freq[s.value];
+            }
+        }
+        lit_freq[256] = 1;
+        // Keep both codes complete, which every decoder accepts
+        lit_freq[0] = std::max<std::uint32_t>(lit_freq[0], 1);
+        dist_freq[0] = std::max<std::uint32_t>(dist_freq[0], 1);
+        dist_freq[1] = std::max<std::uint32_t>(dist_freq[1], 1);
+
+        unsigned char lengths[286 + 30] {};
+        unsigned char* lit_len = lengths;
+        unsigned char* dist_len = lengths + 286;
+        buildLengths(lit_freq, 286, 15, lit_len);
+        buildLengths(dist_freq, 30, 15, dist_len);
+        std::uint16_t lit_code[286] {};
+        std::uint16_t dist_code[30] {};
+        buildCodes(lit_len, 286, lit_code);
+        buildCodes(dist_len, 30, dist_code);
+
+        std::size_t hlit = 286;
+        while (hlit > 257 && !lit_len[hlit - 1]) { --hlit; }
+        std::size_t hdist = 30;
+        while (hdist > 1 && !dist_len[hdist - 1]) { --hdist; }
+
+        // Run-length encode both length tables as one sequence
+        unsigned char all[286 + 30];
+        std::copy(lit_len, lit_len + hlit, all);
+        std::copy(dist_len, dist_len + hdist, all + hlit);
+        const std::size_t total = hlit + hdist;
+        std::vector<std::uint16_t> rle; // Symbol | extra << 8
+        std::uint32_t cl_freq[19] {};
+        for (std::size_t i = 0; i < total;) {
+            const unsigned char len = all[i];
+            std::size_t run = 1;
+            while (i + run < total && all[i + run] == len) { ++run; }
+            i += run;
+            if (!len) {
+                while (run >= 11) {
+                    const std::size_t r = std::min<std::size_t>(run, 138);
+                    rle.push_back(static_cast<std::uint16_t>(18 | (r - 11) << 8));
+                    run -= r;
+                }
+                if (run >= 3) {
+                    rle.push_back(static_cast<std::uint16_t>(17 | (run - 3) << 8));
+                    run = 0;
+                }
+            } else {
+                rle.push_back(len);
+                --run;
+                while (run >= 3) {
+                    const std::size_t r = std::min<std::size_t>(run, 6);
+                    rle.push_back(static_cast<std::uint16_t>(16 | (r - 3) << 8));
+                    run -= r;
+                }
+            }
+            for (; run; --run) { rle.push_back(len); }
+        }
+        for (std::uint16_t s : rle) { ++cl_freq[s & 0xff]; }
+        unsigned char cl_len[19] {};
+        buildLengths(cl_freq, 19, 7, cl_len);
+        std::uint16_t cl_code[19] {};
+        buildCodes(cl_len, 19, cl_code);
+        std::size_t hclen = 19;
+        while (hclen > 4 && !cl_len[CODE_LENGTH_ORDER[hclen - 1]]) { --hclen; }
+
+        // Header
+        putBits(final ? 1 : 0, 1);
+        putBits(2, 2);
+        putBits(static_cast<std::uint32_t>(hlit - 257), 5);
+        putBits(static_cast<std::uint32_t>(hdist - 1), 5);
+        putBits(static_cast<std::uint32_t>(hclen - 4), 4);
+        for (std::size_t i = 0; i < hclen; ++i) {
+            putBits(cl_len[CODE_LENGTH_ORDER[i]], 3);
+        }
+        for (std::uint16_t s : rle) {
+            const unsigned sym = s & 0xff;
+            putBits(cl_code[sym], cl_len[sym]);
+            if (sym == 16) { putBits(s >> 8, 2); }
+            else if (sym == 17) { putBits(s >> 8, 3); }
+            else if (sym == 18) { putBits(s >> 8, 7); }
+        }
+
+        // Data
+        for (const Symbol& s : _symbols) {
+            if (s.distance) {
+                const unsigned lc = t.length_code[s.value];
+                putBits(lit_code[257 + lc], lit_len[257 + lc]);
+                putBits(s.value - LENGTH_BASE[lc], LENGTH_EXTRA[lc]);
+                const unsigned dc = getDistanceCode(t, s.distance);
+                putBits(dist_code[dc], dist_len[dc]);
+                putBits(s.distance - DISTANCE_BASE[dc], DISTANCE_EXTRA[dc]);
+            } else {
+                putBits(lit_code[s.value], lit_len[s.value]);
+            }
+        }
+        putBits(lit_code[256], lit_len[256]);
+        _symbols.clear();
+    }
+
+public:
+    explicit DeflateEncoder(DeflateEffort effort = DeflateEffort::Default):
+        _effort(effort),
+        _head(static_cast<std::size_t>(1) << HASH_BITS),
+        _prev(WINDOW_SIZE) {
+        _symbols.reserve(BLOCK_SYMBOLS);
+    }
+
+    /// \brief Compresses \c data[start, size) into raw deflate blocks appended to \c out
+    /// \param data The data, the first \c start bytes of which only serve as the dictionary (the last 32 KiB is used)
+    /// \param final Whether this piece ends the stream; otherwise it ends with a sync flush, byte-aligned,
+    /// so that the next piece can be appended right after it
+    void compress(const unsigned char* data, std::size_t start, std::size_t size, bool final, std::vector<unsigned char>& out) {
+        const int max_chain = _effort == DeflateEffort::Fast ? 1 : 16;
+        const bool index_matched = _effort != DeflateEffort::Fast;
+
+        _out = &out;
+        _bit_buffer = 0;
+        _bit_count = 0;
+        _symbols.clear();
+        std::fill(_head.begin(), _head.end(), -1);
+
+        const auto insert = [&](std::size_t pos) {
+            std::int32_t& head = _head[hash(data + pos)];
+            _prev[pos & (WINDOW_SIZE - 1)] = head;
+            head = static_cast<std::int32_t>(pos);
+        };
+
+        // Index the dictionary
+        for (std::size_t pos = start > WINDOW_SIZE ? start - WINDOW_SIZE : 0; pos < start && pos + MIN_MATCH <= size; ++pos) {
+            insert(pos);
+        }
+
+        for (std::size_t pos = start; pos < size;) {
+            std::size_t best_len = 0;
+            std::size_t best_dist = 0;
+            if (pos + MIN_MATCH <= size) {
+                const std::size_t max_len = std::min(MAX_MATCH, size - pos);
+                std::int32_t candidate = _head[hash(data + pos)];
+                for (int chain = max_chain; candidate >= 0 && pos - candidate <= WINDOW_SIZE && chain > 0; --chain) {
+                    const unsigned char* match = data + candidate;
+                    if (match[best_len] == data[pos + best_len]) {
+                        const std::size_t len = getMatchLength(match, data + pos, max_len);
+                        if (len > best_len) {
+                            best_len = len;
+                            best_dist = pos - candidate;
+                            if (len == max_len) { break; }
+                        }
+                    }
+                    const std::int32_t next = _prev[candidate & (WINDOW_SIZE - 1)];
+                    if (next >= candidate) { break; } // Overwritten slot, the chain ends here
+                    candidate = next;
+                }
+                insert(pos);
+            }
+
+            if (best_len >= MIN_MATCH) {
+                _symbols.push_back({ static_cast<std::uint16_t>(best_len), static_cast<std::uint16_t>(best_dist) });
+                if (index_matched) {
+                    for (std::size_t p = pos + 1; p < pos + best_len && p + MIN_MATCH <= size; ++p) {
+                        insert(p);
+                    }
+                }
+                pos += best_len;
+            } else {
+                _symbols.push_back({ data[pos], 0 });
+                ++pos;
+            }
+
+            if (_symbols.size() >= BLOCK_SYMBOLS) {
+                writeBlock(false);
+            }
+        }
+
+        if (!_symbols.empty() || final) {
+            writeBlock(final);
+        }
+        if (!final) {
+            // Sync flush: an empty stored block, which leaves the output byte-aligned
+            putBits(0, 3);
+            alignToByte();
+            const unsigned char marker[] { 0x00, 0x00, 0xff, 0xff };
+            out.insert(out.end(), marker, marker + 4);
+        } else {
+            alignToByte();
+        }
+        _out = nullptr;
+    }
+};
+}
+
+#endif // _DEFLATE_HPP_
@@ -0,0 +1,118 @@
+// Created: 2026-10-16
+
+#ifndef _HASH_HPP_
+#define _HASH_HPP_
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Size of the chunks \c hashParallel hashes independently
+inline static constexpr std::size_t HASH_CHUNK_BYTES = static_cast<std::size_t>(1) << 20;
+
+#pragma region XXH64 internals
+
+inline static constexpr std::uint64_t XXH64_PRIME_1 = 11400714785074694791ull;
+inline static constexpr std::uint64_t XXH64_PRIME_2 = 14029467366897019727ull;
+inline static constexpr std::uint64_t XXH64_PRIME_3 = 1609587929392839161ull;
+inline static constexpr std::uint64_t XXH64_PRIME_4 = 9650029242287828579ull;
+inline static constexpr std::uint64_t XXH64_PRIME_5 = 2870177450012600261ull;
+
+inline std::uint64_t rotateLeft64(std::uint64_t x, int r) noexcept {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline std::uint64_t xxh64Round(std::uint64_t acc, std::uint64_t input) noexcept {
+    return rotateLeft64(acc + input * XXH64_PRIME_2, 31) * XXH64_PRIME_1;
+}
+
+inline std::uint64_t xxh64Merge(std::uint64_t acc, std::uint64_t value) noexcept {
+    return (acc ^ xxh64Round(0, value)) * XXH64_PRIME_1 + XXH64_PRIME_4;
+}
+
+inline std::uint64_t readLittle64(const unsigned char* p) noexcept {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline std::uint32_t readLittle32(const unsigned char* p) noexcept {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+#pragma endregion
+
+/// \brief Computes the XXH64 hash of a buffer
+/// \param seed Seed of the hash, 0 for the standard one
+inline std::uint64_t xxHash64(const void* data, std::size_t size, std::uint64_t seed = 0) noexcept {
+    const auto* p = static_cast<const unsigned char*>(data);
+    const unsigned char* const end = p + size;
+    std::uint64_t h;
+
+    if (size >= 32) {
+        std::uint64_t v1 = seed + XXH64_PRIME_1 + XXH64_PRIME_2;
+        std::uint64_t v2 = seed + XXH64_PRIME_2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - XXH64_PRIME_1;
+        for (; end - p >= 32; p += 32) {
+            v1 = xxh64Round(v1, readLittle64(p));
+            v2 = xxh64Round(v2, readLittle64(p + 8));
+            v3 = xxh64Round(v3, readLittle64(p + 16));
+            v4 = xxh64Round(v4, readLittle64(p + 24));
+        }
+        h = rotateLeft64(v1, 1) + rotateLeft64(v2, 7) + rotateLeft64(v3, 12) + rotateLeft64(v4, 18);
+        h = xxh64Merge(h, v1);
+        h = xxh64Merge(h, v2);
+        h = xxh64Merge(h, v3);
+        h = xxh64Merge(h, v4);
+    } else {
+        h = seed + XXH64_PRIME_5;
+    }
+    h += size;
+
+    for (; end - p >= 8; p += 8) {
+        h = rotateLeft64(h ^ xxh64Round(0, readLittle64(p)), 27) * XXH64_PRIME_1 + XXH64_PRIME_4;
+    }
+    if (end - p >= 4) {
+        h = rotateLeft64(h ^ (readLittle32(p) * XXH64_PRIME_1), 23) * XXH64_PRIME_2 + XXH64_PRIME_3;
+        p += 4;
+    }
+    for (; p != end; ++p) {
+        h = rotateLeft64(h ^ (*p * XXH64_PRIME_5), 11) * XXH64_PRIME_1;
+    }
+
+    h ^= h >> 33;
+    h *= XXH64_PRIME_2;
+    h ^= h >> 29;
+    h *= XXH64_PRIME_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/// \brief Hashes a buffer as a tree of XXH64 hashes, so that big buffers are hashed on all threads
+/// \details Every \c HASH_CHUNK_BYTES chunk is hashed with its index as the seed, then the chunk hashes are hashed
+/// together seeded with the total size. The result doesn't depend on the pool.
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+inline std::uint64_t hashParallel(const void* data, std::size_t size, ThreadPool* pool = nullptr) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    const std::size_t chunks = std::max<std::size_t>(1, (size + HASH_CHUNK_BYTES - 1) / HASH_CHUNK_BYTES);
+    std::vector<std::uint64_t> digests(chunks);
+    parallelFor(pool, 0, chunks, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i) {
+            const std::size_t offset = i * HASH_CHUNK_BYTES;
+            digests[i] = xxHash64(bytes + offset, std::min(HASH_CHUNK_BYTES, size - offset), i);
+        }
+    });
+    return xxHash64(digests.data(), chunks * sizeof(std::uint64_t), size);
+}
+}
+
+#endif // _HASH_HPP_
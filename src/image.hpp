@@ -5,7 +5,12 @@
 
 #include "color.hpp"
 #include "pathutils.hpp"
+#include "png.hpp"
+#include "pnm.hpp"
+#include "thread_pool.hpp"
 
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -86,7 +91,7 @@ public:
     /// \brief Returns the bit depth of the image, i.e. 8 x the number of channels
     int getFileBitDepth() const noexcept { return _file_channels * 8; }
     /// \brief Returns the total number of pixels on the image
-    std::size_t getTotalPixels() const noexcept { return _w * _h; } // NOLINT(*)
+    std::uint64_t getTotalPixels() const noexcept { return static_cast<std::uint64_t>(_w) * static_cast<std::uint64_t>(_h); }
 
     /// \brief Pixel-wise iterator \c begin
     Color* begin() noexcept { return _begin; }
@@ -147,12 +152,18 @@ public:
 
     /// \brief Saves the image file
     /// \param path Path of the image file created / \b overwritten
-    void save(const char* path) const {
+    /// \param pool The pool to spread PNG encoding across; runs on the calling thread if \c nullptr
+    /// \param png_effort Trade-off between PNG file size and encoding speed
+    void save(const char* path, ThreadPool* pool = nullptr, PngEffort png_effort = PngEffort::Default) const {
         const std::string ext = Pathutils::getExtensionName(path);
         bool bad_flag = false;
 
         if (ext == "png") {
-            bad_flag = !stbi_write_png(path, _w, _h, 4, _data, _w * 4);
+            writePng(path, _begin, _w, _h, png_effort, pool);
+        } else if (ext == "ppm" || ext == "pam") {
+            PnmWriter writer { path, _w, _h, ext == "pam" };
+            writer.writeRows(_begin, static_cast<std::size_t>(_h));
+            writer.finish();
         } else if (ext == "jpg" || ext == "jpeg") {
             bad_flag = !stbi_write_jpg(path, _w, _h, 4, _data, 90);
         } else if (ext == "tga") {
@@ -172,10 +183,39 @@ public:
 
     /// \brief Saves the image file
     /// \param path Path of the image file created / \b overwritten
-    void save(const std::string& path) const {
-        save(path.c_str());
+    /// \param pool The pool to spread PNG encoding across; runs on the calling thread if \c nullptr
+    /// \param png_effort Trade-off between PNG file size and encoding speed
+    void save(const std::string& path, ThreadPool* pool = nullptr, PngEffort png_effort = PngEffort::Default) const {
+        save(path.c_str(), pool, png_effort);
     }
 };
+
+/// \brief Opens an image for reading row by row
+/// \return The reader, or \c nullptr if the format can't be streamed
+inline std::unique_ptr<RowReader> openRowReader(const std::string& path) {
+    const std::string ext = Pathutils::getExtensionName(path);
+    if (ext == "png") {
+        return std::make_unique<PngReader>(path);
+    }
+    if (ext == "ppm" || ext == "pgm" || ext == "pam") {
+        return std::make_unique<PnmReader>(path);
+    }
+    return nullptr;
+}
+
+/// \brief Creates an image for writing row by row
+/// \param png_effort Trade-off between PNG file size and encoding speed
+/// \return The writer, or \c nullptr if the format can't be streamed
+inline std::unique_ptr<RowWriter> openRowWriter(const std::string& path, int w, int h, PngEffort png_effort = PngEffort::Default) {
+    const std::string ext = Pathutils::getExtensionName(path);
+    if (ext == "png") {
+        return std::make_unique<PngWriter>(path, w, h, png_effort);
+    }
+    if (ext == "ppm" || ext == "pam") {
+        return std::make_unique<PnmWriter>(path, w, h, ext == "pam");
+    }
+    return nullptr;
+}
 }
 
 #endif // _IMAGE_HPP_
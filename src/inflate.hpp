@@ -0,0 +1,284 @@
+// Created: 2026-10-16
+
+#ifndef _INFLATE_HPP_
+#define _INFLATE_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Streaming raw deflate (RFC 1951) decompressor
+/// \details Compressed bytes are pulled from a source callback as needed, and decompressed bytes are handed out in pieces
+/// of any size, so neither side of the stream has to fit in memory.
+class Inflater {
+public:
+    /// \brief Fills the buffer with up to the given number of compressed bytes, returns how many, 0 at the end of input
+    using Source = std::function<std::size_t(unsigned char* buffer, std::size_t size)>;
+
+private:
+    inline static constexpr std::size_t WINDOW_SIZE = 32768;
+    inline static constexpr std::size_t INPUT_BUFFER_SIZE = 1 << 16;
+
+    inline static constexpr std::array<std::uint16_t, 29> LENGTH_BASE {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    inline static constexpr std::array<unsigned char, 29> LENGTH_EXTRA {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    inline static constexpr std::array<std::uint16_t, 30> DISTANCE_BASE {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    inline static constexpr std::array<unsigned char, 30> DISTANCE_EXTRA {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+    inline static constexpr std::array<unsigned char, 19> CODE_LENGTH_ORDER {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    /// \brief Direct lookup table of a Huffman code, indexed by the next \c bits input bits
+    struct HuffmanTable {
+        std::vector<std::uint16_t> entries; // Symbol | length << 9, 0 for invalid bit patterns
+        int bits = 0;
+    };
+
+    enum class State : unsigned char { BlockHeader, Stored, Huffman, Done };
+
+    Source _source;
+    std::vector<unsigned char> _input;
+    std::size_t _input_pos = 0;
+    std::size_t _input_end = 0;
+    bool _input_exhausted = false;
+    std::uint64_t _bit_buffer = 0;
+    int _bit_count = 0;
+
+    std::vector<unsigned char> _window;
+    std::size_t _window_pos = 0; // Total bytes decompressed so far
+
+    State _state = State::BlockHeader;
+    bool _final = false;
+    std::size_t _stored_left = 0;
+    std::size_t _match_left = 0;
+    std::size_t _match_distance = 0;
+    HuffmanTable _lit_table;
+    HuffmanTable _dist_table;
+
+    [[noreturn]] static void fail(const char* what) {
+        throw std::runtime_error { std::string { "corrupt deflate stream: " } + what };
+    }
+
+    /// \brief Tops the bit buffer up to at least \c count bits, or whatever is left of the input
+    void refill(int count) {
+        while (_bit_count < count) {
+            if (_input_pos == _input_end) {
+                if (_input_exhausted) {
+                    return;
+                }
+                _input_end = _source(_input.data(), _input.size());
+                _input_pos = 0;
+                if (!_input_end) {
+                    _input_exhausted = true;
+                    return;
+                }
+            }
+            _bit_buffer |= static_cast<std::uint64_t>(_input[_input_pos++]) << _bit_count;
+            _bit_count += 8;
+        }
+    }
+
+    std::uint32_t getBits(int count) {
+        if (!count) { return 0; }
+        refill(count);
+        if (_bit_count < count) { fail("unexpected end of data"); }
+        const std::uint32_t bits = static_cast<std::uint32_t>(_bit_buffer & ((static_cast<std::uint64_t>(1) << count) - 1));
+        _bit_buffer >>= count;
+        _bit_count -= count;
+        return bits;
+    }
+
+    static void buildTable(const unsigned char* lengths, std::size_t n, HuffmanTable& table) {
+        unsigned count[16] {};
+        int max_len = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            ++count[lengths[i]];
+            max_len = std::max(max_len, static_cast<int>(lengths[i]));
+        }
+        count[0] = 0;
+
+        // Reject over-subscribed codes, incomplete ones are tolerated as some encoders emit them for single codes
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left = (left << 1) - static_cast<int>(count[len]);
+            if (left < 0) { fail("over-subscribed Huffman code"); }
+        }
+
+        unsigned next[16] {};
+        for (int len = 1, code = 0; len < 16; ++len) {
+            code = (code + static_cast<int>(count[len - 1])) << 1;
+            next[len] = static_cast<unsigned>(code);
+        }
+
+        table.bits = std::max(max_len, 1);
+        table.entries.assign(static_cast<std::size_t>(1) << table.bits, 0);
+        for (std::size_t sym = 0; sym < n; ++sym) {
+            const int len = lengths[sym];
+            if (!len) { continue; }
+            unsigned code = next[len]++;
+            unsigned reversed = 0;
+            for (int k = 0; k < len; ++k) {
+                reversed = (reversed << 1) | (code & 1);
+                code >>= 1;
+            }
+            const std::uint16_t entry = static_cast<std::uint16_t>(sym | len << 9);
+            for (std::size_t i = reversed; i < table.entries.size(); i += static_cast<std::size_t>(1) << len) {
+                table.entries[i] = entry;
+            }
+        }
+    }
+
+    unsigned decodeSymbol(const HuffmanTable& table) {
+        refill(table.bits);
+        const std::uint16_t entry = table.entries[_bit_buffer & ((static_cast<std::uint64_t>(1) << table.bits) - 1)];
+        const int len = entry >> 9;
+        if (!len || len > _bit_count) { fail("invalid Huffman code"); }
+        _bit_buffer >>= len;
+        _bit_count -= len;
+        return entry & 0x1ff;
+    }
+
+    void readBlockHeader() {
+        _final = getBits(1);
+        const std::uint32_t type = getBits(2);
+        if (type == 0) {
+            // Stored, skip to the byte boundary
+            getBits(_bit_count & 7);
+            const std::uint32_t len = getBits(16);
+            const std::uint32_t nlen = getBits(16);
+            if ((len ^ 0xffff) != nlen) { fail("stored block length mismatch"); }
+            _stored_left = len;
+            _state = State::Stored;
+        } else if (type == 1) {
+            unsigned char lengths[288 + 30];
+            std::fill(lengths, lengths + 144, static_cast<unsigned char>(8));
+            std::fill(lengths + 144, lengths + 256, static_cast<unsigned char>(9));
+            std::fill(lengths + 256, lengths + 280, static_cast<unsigned char>(7));
+            std::fill(lengths + 280, lengths + 288, static_cast<unsigned char>(8));
+            std::fill(lengths + 288, lengths + 318, static_cast<unsigned char>(5));
+            buildTable(lengths, 288, _lit_table);
+            buildTable(lengths + 288, 30, _dist_table);
+            _state = State::Huffman;
+        } else if (type == 2) {
+            const std::size_t hlit = getBits(5) + 257;
+            const std::size_t hdist = getBits(5) + 1;
+            const std::size_t hclen = getBits(4) + 4;
+            if (hlit > 286 || hdist > 30) { fail("too many length or distance codes"); }
+            unsigned char cl_lengths[19] {};
+            for (std::size_t i = 0; i < hclen; ++i) {
+                cl_lengths[CODE_LENGTH_ORDER[i]] = static_cast<unsigned char>(getBits(3));
+            }
+            HuffmanTable cl_table;
+            buildTable(cl_lengths, 19, cl_table);
+
+            unsigned char lengths[286 + 30] {};
+            for (std::size_t i = 0; i < hlit + hdist;) {
+                const unsigned sym = decodeSymbol(cl_table);
+                std::size_t repeat = 1;
+                unsigned char value = static_cast<unsigned char>(sym);
+                if (sym == 16) {
+                    if (!i) { fail("repeat with no previous length"); }
+                    value = lengths[i - 1];
+                    repeat = 3 + getBits(2);
+                } else if (sym == 17) {
+                    value = 0;
+                    repeat = 3 + getBits(3);
+                } else if (sym == 18) {
+                    value = 0;
+                    repeat = 11 + getBits(7);
+                }
+                if (i + repeat > hlit + hdist) { fail("code lengths overflow"); }
+                std::fill(lengths + i, lengths + i + repeat, value);
+                i += repeat;
+            }
+            if (!lengths[256]) { fail("missing end-of-block code"); }
+            buildTable(lengths, hlit, _lit_table);
+            buildTable(lengths + hlit, hdist, _dist_table);
+            _state = State::Huffman;
+        } else {
+            fail("invalid block type");
+        }
+    }
+
+    void emit(unsigned char* out, std::size_t& produced, unsigned char byte) noexcept {
+        out[produced++] = byte;
+        _window[_window_pos++ & (WINDOW_SIZE - 1)] = byte;
+    }
+
+public:
+    explicit Inflater(Source source):
+        _source(std::move(source)),
+        _input(INPUT_BUFFER_SIZE),
+        _window(WINDOW_SIZE) {}
+
+    /// \brief Decompresses up to \c size bytes
+    /// \return Number of bytes decompressed, less than \c size only at the end of the stream
+    std::size_t read(unsigned char* out, std::size_t size) {
+        std::size_t produced = 0;
+        while (produced < size) {
+            if (_match_left) {
+                std::size_t n = std::min(_match_left, size - produced);
+                _match_left -= n;
+                for (; n; --n) {
+                    emit(out, produced, _window[(_window_pos - _match_distance) & (WINDOW_SIZE - 1)]);
+                }
+                continue;
+            }
+
+            if (_state == State::Done) {
+                break;
+            }
+            if (_state == State::BlockHeader) {
+                readBlockHeader();
+                continue;
+            }
+            if (_state == State::Stored) {
+                if (!_stored_left) {
+                    _state = _final ? State::Done : State::BlockHeader;
+                    continue;
+                }
+                emit(out, produced, static_cast<unsigned char>(getBits(8)));
+                --_stored_left;
+                continue;
+            }
+
+            const unsigned sym = decodeSymbol(_lit_table);
+            if (sym < 256) {
+                emit(out, produced, static_cast<unsigned char>(sym));
+            } else if (sym == 256) {
+                _state = _final ? State::Done : State::BlockHeader;
+            } else {
+                const unsigned lc = sym - 257;
+                if (lc >= 29) { fail("invalid length code"); }
+                _match_left = LENGTH_BASE[lc] + getBits(LENGTH_EXTRA[lc]);
+                const unsigned dc = decodeSymbol(_dist_table);
+                if (dc >= 30) { fail("invalid distance code"); }
+                _match_distance = DISTANCE_BASE[dc] + getBits(DISTANCE_EXTRA[dc]);
+                if (_match_distance > _window_pos) { fail("distance too far back"); }
+            }
+        }
+        return produced;
+    }
+
+    /// \brief Returns whether the final block has been fully decompressed
+    bool isDone() const noexcept { return _state == State::Done && !_match_left; }
+};
+}
+
+#endif // _INFLATE_HPP_
@@ -0,0 +1,290 @@
+// Created: 2026-10-16
+
+#ifndef _LATTICE_HPP_
+#define _LATTICE_HPP_
+
+#include "apply.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Default number of nodes along each axis of a \c LatticeLut, the one most .cube files use
+inline static constexpr int LATTICE_DEFAULT_SIZE = 33;
+
+/// \brief Fixed-point precision of the interpolation weights of a \c LatticeLut
+inline static constexpr int LATTICE_WEIGHT_BITS = 16;
+
+/// \brief A LUT resampled to N x N x N nodes, applied with tetrahedral interpolation
+/// \details At 33 nodes per axis the whole lattice takes 144 KiB, so unlike the 256 ^ 3 cache it stays in L2 while applying.
+/// Nodes are placed on \c sampleSpan(0, 255, N), where the lattice reproduces the cache exactly.
+class LatticeLut {
+    int _size = 0;
+
+    /// \brief Node colors, R index varies fastest, then G, then B; alpha unused
+    std::vector<Color> _nodes {};
+
+    /// \brief For each channel (R, G, B) and each 8-bit value: offset of the lower node of the cell containing it, in nodes
+    std::array<std::array<int, 256>, 3> _cells {};
+
+    /// \brief For each 8-bit value: how far it is from the lower node towards the upper one, in \c LATTICE_WEIGHT_BITS fixed point
+    std::array<int, 256> _weights {};
+
+    void initCells() {
+        const auto sample_points = sampleSpan(0, 255, _size);
+        int cell = 0;
+        for (int v = 0; v < 256; ++v) {
+            while (cell < _size - 2 && v > sample_points[cell + 1]) {
+                ++cell;
+            }
+            const int span = sample_points[cell + 1] - sample_points[cell];
+            _cells[0][v] = cell;
+            _cells[1][v] = cell * _size;
+            _cells[2][v] = cell * _size * _size;
+            _weights[v] = ((v - sample_points[cell]) << LATTICE_WEIGHT_BITS) / span;
+        }
+    }
+
+    explicit LatticeLut(int size):
+        _size(size) {
+        if (size < 2 || size > 256) {
+            throw std::runtime_error { "lattice size must be within [2, 256]" };
+        }
+        initCells();
+        _nodes.resize(static_cast<std::size_t>(size) * size * size);
+    }
+
+public:
+    /// \brief Builds a lattice from any color mapping, evaluated only at the nodes
+    /// \param size Number of nodes along each axis, at least 2 and at most 256
+    /// \param sampler Callable taking a \c Color and returning the mapped \c Color
+    template <typename SamplerTy>
+    static LatticeLut sample(int size, SamplerTy&& sampler) {
+        LatticeLut lattice { size };
+        const auto sample_points = sampleSpan(0, 255, size);
+        Color* node = lattice._nodes.data();
+        for (int b_index = 0; b_index < size; ++b_index) {
+            for (int g_index = 0; g_index < size; ++g_index) {
+                for (int r_index = 0; r_index < size; ++r_index) {
+                    const Color mapped = sampler(Color {
+                        static_cast<unsigned char>(sample_points[r_index]),
+                        static_cast<unsigned char>(sample_points[g_index]),
+                        static_cast<unsigned char>(sample_points[b_index]),
+                        255
+                    });
+                    *node++ = { mapped.r, mapped.g, mapped.b, 0 };
+                }
+            }
+        }
+        return lattice;
+    }
+
+    /// \brief Resamples a LUT cache
+    /// \param data LUT data cache of either \c Color or \c ColorRGB
+    /// \param size Number of nodes along each axis, at least 2 and at most 256
+    template <typename EntryTy>
+    LatticeLut(const EntryTy* data, int size):
+        LatticeLut(sample(size, [data](Color rgba) {
+            const EntryTy& mapped = data[rgba.getHexRGB()];
+            return Color { mapped.r, mapped.g, mapped.b, 0 };
+        })) {}
+
+    /// \brief Resamples a LUT cache
+    /// \param data View of a LUT cache of any layout
+    /// \param size Number of nodes along each axis, at least 2 and at most 256
+    LatticeLut(const LutView& data, int size):
+        LatticeLut(data.visit([&](const auto* table) { return LatticeLut { table, size }; })) {}
+
+    /// \brief Returns the number of nodes along each axis
+    int getSize() const noexcept { return _size; }
+    /// \brief Returns the nodes, R index varies fastest, then G, then B
+    const Color* getNodes() const noexcept { return _nodes.data(); }
+    /// \brief Returns the node offsets of the cells containing each 8-bit value of a channel (0 for R, 1 for G, 2 for B)
+    const int* getCells(int channel) const noexcept { return _cells[channel].data(); }
+    /// \brief Returns the interpolation weights of each 8-bit value, in \c LATTICE_WEIGHT_BITS fixed point
+    const int* getWeights() const noexcept { return _weights.data(); }
+
+    /// \brief Returns the mapped value of a color, keeping its alpha
+    Color lookup(Color color) const noexcept {
+        const int fr = _weights[color.r];
+        const int fg = _weights[color.g];
+        const int fb = _weights[color.b];
+        const int dx = 1;
+        const int dy = _size;
+        const int dz = _size * _size;
+
+        // Walk from the lower corner to the upper one along the axes in descending order of weight
+        int first;
+        int second;
+        int w1;
+        int w2;
+        int w3;
+        int max_weight;
+        if (fr >= fg) {
+            if (fg >= fb) {
+                first = dx, second = dx + dy, max_weight = fr, w1 = fr - fg, w2 = fg - fb, w3 = fb;
+            } else if (fr >= fb) {
+                first = dx, second = dx + dz, max_weight = fr, w1 = fr - fb, w2 = fb - fg, w3 = fg;
+            } else {
+                first = dz, second = dz + dx, max_weight = fb, w1 = fb - fr, w2 = fr - fg, w3 = fg;
+            }
+        } else {
+            if (fr >= fb) {
+                first = dy, second = dy + dx, max_weight = fg, w1 = fg - fr, w2 = fr - fb, w3 = fb;
+            } else if (fg >= fb) {
+                first = dy, second = dy + dz, max_weight = fg, w1 = fg - fb, w2 = fb - fr, w3 = fr;
+            } else {
+                first = dz, second = dz + dy, max_weight = fb, w1 = fb - fg, w2 = fg - fr, w3 = fr;
+            }
+        }
+        const int w0 = (1 << LATTICE_WEIGHT_BITS) - max_weight;
+
+        const Color* c0 = _nodes.data() + _cells[0][color.r] + _cells[1][color.g] + _cells[2][color.b];
+        const Color& c1 = c0[first];
+        const Color& c2 = c0[second];
+        const Color& c3 = c0[dx + dy + dz];
+        constexpr int half = 1 << (LATTICE_WEIGHT_BITS - 1);
+        return {
+            static_cast<unsigned char>((c0->r * w0 + c1.r * w1 + c2.r * w2 + c3.r * w3 + half) >> LATTICE_WEIGHT_BITS),
+            static_cast<unsigned char>((c0->g * w0 + c1.g * w1 + c2.g * w2 + c3.g * w3 + half) >> LATTICE_WEIGHT_BITS),
+            static_cast<unsigned char>((c0->b * w0 + c1.b * w1 + c2.b * w2 + c3.b * w3 + half) >> LATTICE_WEIGHT_BITS),
+            color.a
+        };
+    }
+};
+
+/// \brief Replaces every pixel in [begin, end) with its value interpolated from a lattice, keeping the original alpha; portable version
+inline void remapPixelsScalar(Color* begin, Color* end, const LatticeLut& lut) noexcept {
+    for (Color* px = begin; px != end; ++px) {
+        *px = lut.lookup(*px);
+    }
+}
+
+#if defined(LUTOOLS_X86)
+
+/// \brief Extracts the channel at bit \c shift of 8 nodes and multiplies it by their weights
+LUTOOLS_TARGET("avx2") inline __m256i weighChannelAvx2(__m256i nodes, __m256i shift, __m256i weights) noexcept {
+    return _mm256_mullo_epi32(_mm256_and_si256(_mm256_srlv_epi32(nodes, shift), _mm256_set1_epi32(0xff)), weights);
+}
+
+/// \brief AVX2 version of \c remapPixelsScalar for lattices, 8 pixels at a time, branch-free
+LUTOOLS_TARGET("avx2") inline void remapPixelsAvx2(Color* begin, Color* end, const LatticeLut& lut) noexcept {
+    const int size = lut.getSize();
+    const int* nodes = reinterpret_cast<const int*>(lut.getNodes());
+    const int* weights = lut.getWeights();
+    const __m256i byte_mask = _mm256_set1_epi32(0xff);
+    const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+    const __m256i one = _mm256_set1_epi32(1 << LATTICE_WEIGHT_BITS);
+    const __m256i half = _mm256_set1_epi32(1 << (LATTICE_WEIGHT_BITS - 1));
+    const __m256i dx = _mm256_set1_epi32(1);
+    const __m256i dy = _mm256_set1_epi32(size);
+    const __m256i dz = _mm256_set1_epi32(size * size);
+    const __m256i dxyz = _mm256_set1_epi32(1 + size + size * size);
+
+    Color* px = begin;
+    for (; end - px >= 8; px += 8) {
+        const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(px));
+        const __m256i r = _mm256_and_si256(src, byte_mask);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(src, 8), byte_mask);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(src, 16), byte_mask);
+
+        const __m256i base = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_i32gather_epi32(lut.getCells(0), r, 4), _mm256_i32gather_epi32(lut.getCells(1), g, 4)),
+            _mm256_i32gather_epi32(lut.getCells(2), b, 4));
+        const __m256i fr = _mm256_i32gather_epi32(weights, r, 4);
+        const __m256i fg = _mm256_i32gather_epi32(weights, g, 4);
+        const __m256i fb = _mm256_i32gather_epi32(weights, b, 4);
+
+        // Sorted weights, hi >= mid >= lo
+        const __m256i hi = _mm256_max_epi32(_mm256_max_epi32(fr, fg), fb);
+        const __m256i lo = _mm256_min_epi32(_mm256_min_epi32(fr, fg), fb);
+        const __m256i mid = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(fr, fg), fb), hi), lo);
+
+        // Axis of the highest weight (ties go to R, then G) and of the lowest (ties go to B, then G), never the same one
+        const __m256i r_lt_g = _mm256_cmpgt_epi32(fg, fr);
+        const __m256i r_lt_b = _mm256_cmpgt_epi32(fb, fr);
+        const __m256i g_lt_b = _mm256_cmpgt_epi32(fb, fg);
+        const __m256i r_highest = _mm256_andnot_si256(_mm256_or_si256(r_lt_g, r_lt_b), _mm256_set1_epi32(-1));
+        const __m256i first = _mm256_blendv_epi8(_mm256_blendv_epi8(dy, dz, g_lt_b), dx, r_highest);
+        const __m256i b_lowest = _mm256_andnot_si256(_mm256_or_si256(r_lt_b, g_lt_b), _mm256_set1_epi32(-1));
+        const __m256i last = _mm256_blendv_epi8(_mm256_blendv_epi8(dx, dy, _mm256_andnot_si256(r_lt_g, _mm256_set1_epi32(-1))), dz, b_lowest);
+
+        const __m256i c0 = _mm256_i32gather_epi32(nodes, base, 4);
+        const __m256i c1 = _mm256_i32gather_epi32(nodes, _mm256_add_epi32(base, first), 4);
+        const __m256i c2 = _mm256_i32gather_epi32(nodes, _mm256_sub_epi32(_mm256_add_epi32(base, dxyz), last), 4);
+        const __m256i c3 = _mm256_i32gather_epi32(nodes, _mm256_add_epi32(base, dxyz), 4);
+        const __m256i w0 = _mm256_sub_epi32(one, hi);
+        const __m256i w1 = _mm256_sub_epi32(hi, mid);
+        const __m256i w2 = _mm256_sub_epi32(mid, lo);
+        const __m256i w3 = lo;
+
+        __m256i result = _mm256_and_si256(src, alpha_mask);
+        for (int shift = 0; shift < 24; shift += 8) {
+            const __m256i shift_count = _mm256_set1_epi32(shift);
+            const __m256i sum = _mm256_add_epi32(
+                _mm256_add_epi32(weighChannelAvx2(c0, shift_count, w0), weighChannelAvx2(c1, shift_count, w1)),
+                _mm256_add_epi32(weighChannelAvx2(c2, shift_count, w2), weighChannelAvx2(c3, shift_count, w3)));
+            const __m256i channel = _mm256_srli_epi32(_mm256_add_epi32(sum, half), LATTICE_WEIGHT_BITS);
+            result = _mm256_or_si256(result, _mm256_sllv_epi32(channel, shift_count));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(px), result);
+    }
+    remapPixelsScalar(px, end, lut);
+}
+
+#endif // LUTOOLS_X86
+
+/// \brief Replaces every pixel in [begin, end) with its value interpolated from a lattice, keeping the original alpha
+/// \remark The kernel is chosen on first call by runtime CPU detection
+inline void remapPixels(Color* begin, Color* end, const LatticeLut& lut) noexcept {
+    using LatticeKernel = void (*)(Color*, Color*, const LatticeLut&) noexcept;
+    static const LatticeKernel kernel = [] () -> LatticeKernel {
+#if defined(LUTOOLS_X86)
+        if (getCpuLevel() >= CpuLevel::Avx2) {
+            return remapPixelsAvx2;
+        }
+#endif
+        return remapPixelsScalar;
+    }();
+    kernel(begin, end, lut);
+}
+
+/// \brief Replaces every packed RGB pixel in [begin, end) with its value interpolated from a lattice
+/// \remark Pixels are widened to RGBA in small batches on the stack, so the RGBA kernels do the work
+inline void remapPixels(ColorRGB* begin, ColorRGB* end, const LatticeLut& lut) noexcept {
+    Color batch[1024];
+    for (ColorRGB* px = begin; px != end;) {
+        const std::size_t n = std::min<std::size_t>(1024, static_cast<std::size_t>(end - px));
+        for (std::size_t i = 0; i < n; ++i) {
+            batch[i] = { px[i].r, px[i].g, px[i].b, 255 };
+        }
+        remapPixels(batch, batch + n, lut);
+        for (std::size_t i = 0; i < n; ++i) {
+            px[i] = batch[i].getRGB();
+        }
+        px += n;
+    }
+}
+
+/// \brief Applies a lattice to a range of pixels, split into stripes of \c APPLY_STRIPE_PIXELS across a thread pool
+/// \param begin Pixel-wise iterator \c begin, over \c Color or packed \c ColorRGB
+/// \param end Pixel-wise iterator \c end
+/// \param pool The pool to spread the stripes across; runs on the calling thread if \c nullptr
+template <typename PixelTy>
+void applyLUT(PixelTy* begin, PixelTy* end, const LatticeLut& lut, ThreadPool* pool = nullptr) {
+    parallelFor(pool, 0, static_cast<std::size_t>(end - begin), APPLY_STRIPE_PIXELS, [=, &lut](std::size_t first, std::size_t last) {
+        remapPixels(begin + first, begin + last, lut);
+    });
+}
+
+/// \brief Applies a lattice to an entire image in-place
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+inline void applyLUT(Image& img, const LatticeLut& lut, ThreadPool* pool = nullptr) {
+    applyLUT(img.begin(), img.end(), lut, pool);
+}
+}
+
+#endif // _LATTICE_HPP_
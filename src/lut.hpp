@@ -3,9 +3,29 @@
 #ifndef _LUT_HPP_
 #define _LUT_HPP_
 
+#include "cpu.hpp"
+#include "hash.hpp"
 #include "image.hpp"
+#include "lut_codec.hpp"
+#include "lut_table.hpp"
+#include "mapped_file.hpp"
+#include "pathutils.hpp"
+#include "thread_pool.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
@@ -13,6 +33,438 @@ namespace Lutools {
 
 inline static constexpr size_t LUT_RAW_DATA_SIZE = static_cast<size_t>(256) * 256 * 256;
 
+/// \brief Memory layout of a LUT cache
+enum class LutLayout : unsigned char {
+    /// \brief One \c Color per entry, the alpha channel is unused (64 MiB)
+    RGBA = 0,
+    /// \brief One \c ColorRGB per entry, followed by a spare entry (48 MiB)
+    RGB24 = 1
+};
+
+/// \brief Layout of a LUT cache made of \c EntryTy, which is either \c Color or \c ColorRGB
+template <typename EntryTy>
+inline constexpr LutLayout LUT_LAYOUT_OF = std::is_same_v<EntryTy, ColorRGB> ? LutLayout::RGB24 : LutLayout::RGBA;
+
+/// \brief Number of entries allocated for a LUT cache made of \c EntryTy
+/// \remark \c ColorRGB caches carry a spare entry, so that 4-byte gathers of the last entry never read out of bounds
+template <typename EntryTy>
+inline constexpr size_t LUT_ENTRY_COUNT = LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24 ? LUT_RAW_DATA_SIZE + 1 : LUT_RAW_DATA_SIZE;
+
+/// \brief Returns the size in bytes of a LUT cache of the given layout
+inline size_t getLutPayloadSize(LutLayout layout) noexcept {
+    return layout == LutLayout::RGB24 ? LUT_ENTRY_COUNT<ColorRGB> * sizeof(ColorRGB) : LUT_ENTRY_COUNT<Color> * sizeof(Color);
+}
+
+/// \brief Allocates a table for a LUT cache made of \c EntryTy, leaving the \c LUT_RAW_DATA_SIZE entries to be filled
+/// uninitialized and zeroing the spare one, if any
+template <typename EntryTy>
+LutTable<EntryTy> allocateLutTable() {
+    LutTable<EntryTy> table { LUT_ENTRY_COUNT<EntryTy> };
+    if constexpr (LUT_ENTRY_COUNT<EntryTy> > LUT_RAW_DATA_SIZE) {
+        table[LUT_RAW_DATA_SIZE] = {};
+    }
+    return table;
+}
+
+/// \brief Magic number at the beginning of a .lut v2 file
+inline static constexpr char LUT_FILE_MAGIC[4] = { 'L', 'U', 'T', 'C' };
+
+/// \brief Version number of the .lut files written by this library
+inline static constexpr std::uint32_t LUT_FILE_VERSION = 2;
+
+/// \brief Flag of \c LutFileHeader::flags, set if \c LutFileHeader::checksum holds the hash of the LUT cache
+inline static constexpr std::uint8_t LUT_FILE_HAS_CHECKSUM = 1;
+
+/// \brief Flag of \c LutFileHeader::flags, set if the \c source_* fields describe the file the LUT cache was built from
+inline static constexpr std::uint8_t LUT_FILE_HAS_SOURCE = 2;
+
+/// \brief Value of \c LutSource::axis for sources that aren't lutmaps
+inline static constexpr std::uint8_t LUT_SOURCE_NO_AXIS = 0xff;
+
+/// \brief Header of a .lut v2 file, directly followed by the LUT cache; all fields are little-endian
+/// \remark Version 1 files are headerless dumps of \c LUT_RAW_DATA_SIZE \c Color entries, they are still accepted.
+/// Early version 2 files have \c flags, \c compression and everything after \c payload_size zeroed, they are still
+/// accepted as well.
+struct LutFileHeader {
+    /// \brief Always \c LUT_FILE_MAGIC
+    char magic[4];
+    /// \brief Always \c LUT_FILE_VERSION
+    std::uint32_t version;
+    /// \brief Offset of the LUT cache from the beginning of the file
+    std::uint32_t header_size;
+    /// \brief A \c LutLayout
+    std::uint8_t layout;
+    /// \brief Combination of \c LUT_FILE_HAS_CHECKSUM and \c LUT_FILE_HAS_SOURCE
+    std::uint8_t flags;
+    /// \brief Axis of the source lutmap, 0 for R, 1 for G, 2 for B, or \c LUT_SOURCE_NO_AXIS
+    std::uint8_t source_axis;
+    /// \brief A \c LutCompression
+    std::uint8_t compression;
+    /// \brief Size of the LUT cache in bytes
+    std::uint64_t payload_size;
+    /// \brief \c hashParallel of the LUT cache
+    std::uint64_t checksum;
+    /// \brief \c hashParallel of the source file
+    std::uint64_t source_hash;
+    /// \brief Size of the source file in bytes
+    std::uint64_t source_size;
+    /// \brief Last modification time of the source file, in ticks of \c std::filesystem::file_time_type
+    std::int64_t source_modified;
+    /// \brief Size of the LUT cache as stored in bytes, equal to \c payload_size unless compressed; 0 in early files
+    std::uint64_t stored_size;
+};
+
+static_assert(sizeof(LutFileHeader) == 64, "LutFileHeader must be 64 bytes");
+
+/// \brief Description of the file a LUT cache was built from, recorded in its .lut file
+struct LutSource {
+    /// \brief \c hashParallel of the file
+    std::uint64_t hash;
+    /// \brief Size of the file in bytes
+    std::uint64_t size;
+    /// \brief Last modification time of the file, in ticks of \c std::filesystem::file_time_type
+    std::int64_t modified;
+    /// \brief Axis of a lutmap, 0 for R, 1 for G, 2 for B, or \c LUT_SOURCE_NO_AXIS
+    std::uint8_t axis;
+};
+
+/// \brief Returns the size and last modification time of a file, with a zero hash
+inline LutSource statLutSource(const std::string& path, std::uint8_t axis) {
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        throw std::runtime_error { "unable to access \"" + path + "\"" };
+    }
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    return { 0, static_cast<std::uint64_t>(size), ec ? 0 : static_cast<std::int64_t>(modified.time_since_epoch().count()), axis };
+}
+
+/// \brief Describes a file a LUT cache is built from, hashing its content
+/// \param axis Axis of a lutmap, 0 for R, 1 for G, 2 for B, or \c LUT_SOURCE_NO_AXIS
+/// \param pool The pool to spread hashing across; runs on the calling thread if \c nullptr
+inline LutSource getLutSource(const std::string& path, std::uint8_t axis, ThreadPool* pool = nullptr) {
+    LutSource source = statLutSource(path, axis);
+    const MappedFile file { path };
+    source.hash = hashParallel(file.data(), file.size(), pool);
+    return source;
+}
+
+/// \brief Locates the LUT cache inside a .lut file of any version
+/// \param head The first bytes of the file, as many as \c sizeof(LutFileHeader) or the entire file if it is shorter
+/// \param file_size Size of the entire file in bytes
+/// \param header Receives the header; for a version 1 file, a zeroed header of that version and layout
+/// \return Offset of the LUT cache from the beginning of the file
+inline size_t parseCacheFileHeader(const unsigned char* head, size_t file_size, LutFileHeader& header) {
+    header = {};
+    if (file_size >= sizeof(LutFileHeader)) {
+        std::memcpy(&header, head, sizeof(LutFileHeader));
+    }
+
+    if (std::memcmp(header.magic, LUT_FILE_MAGIC, sizeof(LUT_FILE_MAGIC)) != 0) {
+        // Version 1, headerless
+        if (file_size != LUT_RAW_DATA_SIZE * sizeof(Color)) {
+            throw std::runtime_error { "invalid LUT file" };
+        }
+        header = {};
+        header.version = 1;
+        header.layout = static_cast<std::uint8_t>(LutLayout::RGBA);
+        header.payload_size = file_size;
+        return 0;
+    }
+
+    if (header.version != LUT_FILE_VERSION) {
+        throw std::runtime_error { "unsupported LUT file version " + std::to_string(header.version) };
+    }
+    if (header.layout > static_cast<std::uint8_t>(LutLayout::RGB24)) {
+        throw std::runtime_error { "unsupported LUT file layout" };
+    }
+    if (header.compression > static_cast<std::uint8_t>(LutCompression::DeltaDeflate)) {
+        throw std::runtime_error { "unsupported LUT file compression" };
+    }
+    if (!header.compression) {
+        header.stored_size = header.payload_size;
+    }
+    const auto layout = static_cast<LutLayout>(header.layout);
+    if (header.header_size < sizeof(LutFileHeader)
+        || header.payload_size != getLutPayloadSize(layout)
+        || header.header_size + header.stored_size != file_size) {
+        throw std::runtime_error { "invalid LUT file" };
+    }
+    return header.header_size;
+}
+
+/// \brief Retrieves the LUT cache of a .lut file from what is stored, decompressing it if needed
+/// \param stored The stored LUT cache, \c header.stored_size bytes
+/// \param payload Receives the LUT cache, \c header.payload_size bytes
+/// \param pool The pool to spread decompression across; runs on the calling thread if \c nullptr
+inline void decodeCachePayload(const LutFileHeader& header, const unsigned char* stored, unsigned char* payload, ThreadPool* pool = nullptr) {
+    if (header.compression == static_cast<std::uint8_t>(LutCompression::DeltaDeflate)) {
+        const std::size_t entry_size = header.layout == static_cast<std::uint8_t>(LutLayout::RGB24) ? sizeof(ColorRGB) : sizeof(Color);
+        decompressLutPayload(stored, header.stored_size, payload, header.payload_size, entry_size, pool);
+    } else {
+        std::memcpy(payload, stored, header.payload_size);
+    }
+}
+
+/// \brief Checks the LUT cache of a .lut file against the checksum in its header
+/// \param payload The LUT cache, \c header.payload_size bytes
+/// \param pool The pool to spread hashing across; runs on the calling thread if \c nullptr
+/// \return Whether there was a checksum to check against
+/// \throw std::runtime_error If the checksum doesn't match
+inline bool verifyCacheChecksum(const LutFileHeader& header, const unsigned char* payload, ThreadPool* pool = nullptr) {
+    if (!(header.flags & LUT_FILE_HAS_CHECKSUM)) {
+        return false;
+    }
+    if (hashParallel(payload, header.payload_size, pool) != header.checksum) {
+        throw std::runtime_error { "LUT file checksum mismatch, the file is corrupted" };
+    }
+    return true;
+}
+
+/// \brief Writes a LUT cache to a .lut v2 file, along with its checksum
+/// \param data LUT data cache of either \c Color or \c ColorRGB, having \c LUT_ENTRY_COUNT entries
+/// \param output_file Path of the output (.lut format)
+/// \param pool The pool to spread hashing across; runs on the calling thread if \c nullptr
+/// \param source The file the cache is built from, if any, so that \c isCacheFileUpToDate can tell when it changes
+/// \param compression How to store the cache: as is, so that it can be mapped, or compressed, hundreds of times smaller
+/// for a smooth LUT, but decompressed into memory whenever loaded; a cache that wouldn't shrink is stored as is
+template <typename EntryTy>
+void saveCacheToFile(
+    const EntryTy* data,
+    const std::string& output_file,
+    ThreadPool* pool = nullptr,
+    const LutSource* source = nullptr,
+    LutCompression compression = LutCompression::None) {
+    LutFileHeader header {};
+    std::memcpy(header.magic, LUT_FILE_MAGIC, sizeof(LUT_FILE_MAGIC));
+    header.version = LUT_FILE_VERSION;
+    header.header_size = sizeof(LutFileHeader);
+    header.layout = static_cast<std::uint8_t>(LUT_LAYOUT_OF<EntryTy>);
+    header.payload_size = getLutPayloadSize(LUT_LAYOUT_OF<EntryTy>);
+    header.flags = LUT_FILE_HAS_CHECKSUM;
+    header.checksum = hashParallel(data, header.payload_size, pool);
+    header.source_axis = LUT_SOURCE_NO_AXIS;
+    if (source) {
+        header.flags |= LUT_FILE_HAS_SOURCE;
+        header.source_axis = source->axis;
+        header.source_hash = source->hash;
+        header.source_size = source->size;
+        header.source_modified = source->modified;
+    }
+
+    std::vector<unsigned char> compressed {};
+    const unsigned char* stored = reinterpret_cast<const unsigned char*>(data);
+    header.compression = static_cast<std::uint8_t>(compression);
+    header.stored_size = header.payload_size;
+    if (compression == LutCompression::DeltaDeflate) {
+        compressed = compressLutPayload(stored, header.payload_size, sizeof(EntryTy), pool);
+        // Noise doesn't compress, keep it mappable then
+        if (compressed.size() < header.payload_size) {
+            stored = compressed.data();
+            header.stored_size = compressed.size();
+        } else {
+            header.compression = static_cast<std::uint8_t>(LutCompression::None);
+        }
+    }
+
+    std::ofstream fout;
+    fout.open(output_file, std::ofstream::binary | std::ofstream::trunc);
+    if (!fout.is_open()) {
+        throw std::runtime_error { "unable to create LUT file" };
+    }
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    fout.write(reinterpret_cast<const char*>(stored), static_cast<std::streamsize>(header.stored_size));
+    fout.close();
+    if (fout.fail()) {
+        throw std::runtime_error { "failed to write LUT file" };
+    }
+}
+
+/// \brief Reads the header of a .lut file of any version
+/// \return The header; for a version 1 file, a zeroed header of that version and layout
+inline LutFileHeader readCacheFileHeader(const std::string& path) {
+    std::ifstream fin;
+    fin.open(path, std::ifstream::binary | std::ifstream::ate);
+    if (!fin.is_open()) {
+        throw std::runtime_error { "unable to open LUT file \"" + path + "\"" };
+    }
+    const auto file_size = static_cast<size_t>(fin.tellg());
+    unsigned char head[sizeof(LutFileHeader)] {};
+    fin.seekg(0);
+    fin.read(reinterpret_cast<char*>(head), static_cast<std::streamsize>(std::min(file_size, sizeof(head))));
+
+    LutFileHeader header;
+    parseCacheFileHeader(head, file_size, header);
+    return header;
+}
+
+/// \brief Checks an entire .lut file against the checksum in its header
+/// \param pool The pool to spread hashing across; runs on the calling thread if \c nullptr
+/// \return Whether there was a checksum to check against
+/// \throw std::runtime_error If the file is invalid or the checksum doesn't match
+inline bool verifyCacheFile(const std::string& path, ThreadPool* pool = nullptr) {
+    const MappedFile file { path };
+    LutFileHeader header;
+    const size_t offset = parseCacheFileHeader(file.data(), file.size(), header);
+    if (header.compression) {
+        std::vector<unsigned char> payload(header.payload_size);
+        decodeCachePayload(header, file.data() + offset, payload.data(), pool);
+        return verifyCacheChecksum(header, payload.data(), pool);
+    }
+    return verifyCacheChecksum(header, file.data() + offset, pool);
+}
+
+/// \brief Rewrites the modification time of the source recorded in a .lut v2 file, leaving the rest untouched
+/// \details Best effort: a .lut file that can't be written, e.g. a read-only one, is left as is.
+inline void recordCacheFileSourceTime(const std::string& path, std::int64_t source_modified) {
+    std::fstream file { path, std::ios::binary | std::ios::in | std::ios::out };
+    if (!file.is_open()) {
+        return;
+    }
+    file.seekp(static_cast<std::streamoff>(offsetof(LutFileHeader, source_modified)));
+    file.write(reinterpret_cast<const char*>(&source_modified), sizeof(source_modified));
+}
+
+/// \brief Checks whether a .lut file still reflects the file it was built from, so that it needn't be rebuilt
+/// \details The source is hashed only if its size or modification time differ from the recorded ones, so a source
+/// that was merely touched or copied over doesn't count as changed; its new time is then recorded in the .lut file. A .lut file that doesn't record its source, or
+/// whose source is gone, is trusted.
+/// \param cache_file Path of the .lut file
+/// \param source_file Path of the lutmap or cube file it is built from
+/// \param pool The pool to spread hashing across; runs on the calling thread if \c nullptr
+/// \return \c false if the .lut file is missing, invalid or out of date
+inline bool isCacheFileUpToDate(const std::string& cache_file, const std::string& source_file, ThreadPool* pool = nullptr) {
+    if (!Pathutils::isFileAvailable(cache_file)) {
+        return false;
+    }
+    if (cache_file == source_file || !Pathutils::isFileAvailable(source_file)) {
+        return true;
+    }
+
+    LutFileHeader header;
+    try {
+        header = readCacheFileHeader(cache_file);
+    }
+    catch (std::exception&) {
+        return false;
+    }
+    if (!(header.flags & LUT_FILE_HAS_SOURCE)) {
+        return true;
+    }
+
+    const LutSource source = statLutSource(source_file, header.source_axis);
+    if (source.size == header.source_size && source.modified == header.source_modified) {
+        return true;
+    }
+    if (source.size != header.source_size || getLutSource(source_file, header.source_axis, pool).hash != header.source_hash) {
+        return false;
+    }
+    // Merely touched, record the new time so that the next check is cheap again
+    recordCacheFileSourceTime(cache_file, source.modified);
+    return true;
+}
+
+/// \brief Read-only view of a LUT cache of any layout, sharing the ownership of whatever stores it
+class LutView {
+    std::shared_ptr<const void> _data {};
+    LutLayout _layout = LutLayout::RGBA;
+
+public:
+    LutView() = default;
+
+    LutView(std::shared_ptr<const Color> data) noexcept: // NOLINT(*-explicit-*)
+        _data(std::move(data)),
+        _layout(LutLayout::RGBA) {}
+
+    LutView(std::shared_ptr<const ColorRGB> data) noexcept: // NOLINT(*-explicit-*)
+        _data(std::move(data)),
+        _layout(LutLayout::RGB24) {}
+
+    LutView(LutTable<Color>&& table): // NOLINT(*-explicit-*)
+        LutView(std::move(table).share()) {}
+
+    LutView(LutTable<ColorRGB>&& table): // NOLINT(*-explicit-*)
+        LutView(std::move(table).share()) {}
+
+    /// \brief Returns the layout of the viewed LUT cache
+    LutLayout getLayout() const noexcept { return _layout; }
+
+    /// \brief Returns the LUT cache if it is made of \c Color, otherwise \c nullptr
+    const Color* getRGBA() const noexcept {
+        return _layout == LutLayout::RGBA ? static_cast<const Color*>(_data.get()) : nullptr;
+    }
+
+    /// \brief Returns the LUT cache if it is made of \c ColorRGB, otherwise \c nullptr
+    const ColorRGB* getRGB24() const noexcept {
+        return _layout == LutLayout::RGB24 ? static_cast<const ColorRGB*>(_data.get()) : nullptr;
+    }
+
+    /// \brief Calls \c fn with the LUT cache as a pointer to its actual entry type
+    template <typename FnTy>
+    decltype(auto) visit(FnTy&& fn) const {
+        if (_layout == LutLayout::RGB24) {
+            return fn(getRGB24());
+        }
+        return fn(getRGBA());
+    }
+
+    /// \brief Returns the number of views sharing the viewed LUT cache, 0 if nothing is viewed
+    long getUseCount() const noexcept { return _data.use_count(); }
+
+    /// \brief Checks if anything is viewed
+    explicit operator bool() const noexcept { return static_cast<bool>(_data); }
+};
+
+
+/// \brief Width and height of a full lutmap
+inline static constexpr int LUTMAP_SIZE = 4096;
+
+/// \brief Largest factor a lutmap may be enlarged by, for a 16384 x 16384 lutmap
+inline static constexpr int LUTMAP_MAX_SCALE = 4;
+
+/// \brief Number of levels of each channel a full lutmap holds, every 8-bit value
+inline static constexpr int LUTMAP_FULL_LEVELS = 256;
+
+/// \brief Checks if a lutmap may hold the given number of levels of each channel: 16, 64 or 256
+/// \details Levels are squares so that the tiles, one per level of the axis channel, make up a square lutmap. A lutmap of
+/// fewer levels holds the colors at \c sampleSpan(0, 255, levels) only, e.g. a 512 x 512 lutmap of 64 levels, which gets
+/// through downscaling apps far better; the rest of the LUT is interpolated.
+inline constexpr bool isValidLUTMapLevels(int levels) noexcept {
+    return levels == 16 || levels == 64 || levels == LUTMAP_FULL_LEVELS;
+}
+
+/// \brief Returns the number of tiles along each side of a lutmap of the given number of levels
+inline constexpr int getLUTMapTiles(int levels) noexcept {
+    return levels == 16 ? 4 : levels == 64 ? 8 : 16;
+}
+
+/// \brief Returns the width and height of a lutmap of the given number of levels, e.g. 512 for 64 levels
+inline constexpr int getLUTMapSize(int levels) noexcept {
+    return getLUTMapTiles(levels) * levels;
+}
+
+/// \brief How a lutmap is laid out, as told by its size
+struct LutMapShape {
+    /// \brief Number of levels of each channel, see \c isValidLUTMapLevels
+    int levels;
+    /// \brief Factor the lutmap was enlarged by, from 1 to \c LUTMAP_MAX_SCALE
+    int scale;
+};
+
+/// \brief Returns the number of levels of a lutmap of the given size and the factor it was enlarged by
+/// \throw std::runtime_error If the lutmap isn't 4096 x 4096, 512 x 512 or 64 x 64, or an exact multiple of these up to
+/// \c LUTMAP_MAX_SCALE times
+inline LutMapShape getLUTMapShape(int w, int h) {
+    // Sizes of different levels never share a multiple up to LUTMAP_MAX_SCALE times
+    for (const int levels : { LUTMAP_FULL_LEVELS, 64, 16 }) {
+        const int size = getLUTMapSize(levels);
+        if (w == h && w % size == 0 && w / size >= 1 && w / size <= LUTMAP_MAX_SCALE) {
+            return { levels, w / size };
+        }
+    }
+    throw std::runtime_error { "LUT map size must be 4096 x 4096, 512 x 512 or 64 x 64, or an exact multiple up to 4 times that" };
+}
+
 /// \brief Map a specific color to a unique 2D position, which maps to a pixel on the lutmap
 /// \param color The color
 /// \param axis Axis channel, whose value enumerates, tile by tile, throughout the entire lutmap: 0 for R, 1 for G, 2 for B
@@ -52,98 +504,571 @@ inline std::vector<int> sampleSpan(int begin, int end, int samples) {
     return sample_points;
 }
 
-/// \brief Analyzes a lutmap and cache the entire LUT, interpolation-free
-/// \param input_file Path of the lutmap
-/// \param output_file Path of the output (.lut format); writing is skipped if empty
-/// \return An array of \c Color which stores the mapped value of all possible colors in the RGB colorspace; the mapped value can be accessed via index returned by \c Color::getHexRGB()
-/// \remark Ensures a valid array of \c Color
-[[nodiscard]] inline Color* cacheLUTMap(const std::string& input_file, const std::string& output_file) {
-    const auto map = std::make_shared<Image>(input_file);
-    if (map->getWidth() != 4096 && map->getHeight() != 4096) {
-        throw std::runtime_error { "LUT map size must be 4096 x 4096" };
+/// \brief Copies every color of a full lutmap into its place in a LUT cache
+/// \param pixels The lutmap, 4096 x 4096 pixels, row by row
+/// \param axis Axis channel of the lutmap: 0 for R, 1 for G, 2 for B
+/// \param data LUT data cache of either \c Color or \c ColorRGB to be filled
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \remark Same result as looking up every color with \c rgbToMapPosition, but the work is split into 16 x 16 x 16 blocks
+/// (16 tiles x 16 rows x 16 pixels) so that every cache line of the lutmap and of the LUT cache is touched once, whichever the axis
+template <typename EntryTy>
+void readFullLUTMap(const Color* pixels, unsigned char axis, EntryTy* data, ThreadPool* pool = nullptr) {
+    const unsigned char h = (axis + 1) % 3;
+    const unsigned char v = (axis + 2) % 3;
+
+    // Bit position of each channel in the index, as in Color::getHexRGB()
+    const int shift_a = 8 * (2 - axis);
+    const int shift_h = 8 * (2 - h);
+    const int shift_v = 8 * (2 - v);
+
+    const ptrdiff_t stride = LUTMAP_SIZE;
+
+    parallelFor(pool, 0, 16 * 16 * 16, 16, [=](size_t first, size_t last) {
+        for (size_t block = first; block < last; ++block) {
+            const int stage_begin = static_cast<int>(block >> 8) * 16;
+            const int y_begin = static_cast<int>((block >> 4) & 15) * 16;
+            const int x_begin = static_cast<int>(block & 15) * 16;
+
+            // All 16 tiles of a block lie on the same row of tiles, so they share the same vertical flipping
+            const bool v_flip = (stage_begin >> 4) & 1;
+            const Color* tile_row = pixels + (stage_begin >> 4) * 256 * stride;
+
+            for (int y = y_begin; y < y_begin + 16; ++y) {
+                const Color* row = tile_row + (v_flip ? 255 - y : y) * stride;
+
+                for (int stage = stage_begin; stage < stage_begin + 16; ++stage) {
+                    // Odd tiles are flipped horizontally
+                    const bool h_flip = stage & 1;
+                    const Color* src = row + (stage & 15) * 256 + (h_flip ? 255 - x_begin : x_begin);
+                    const ptrdiff_t src_step = h_flip ? -1 : 1;
+                    EntryTy* dst = data
+                        + (static_cast<size_t>(stage) << shift_a | static_cast<size_t>(y) << shift_v | static_cast<size_t>(x_begin) << shift_h);
+                    const size_t dst_step = static_cast<size_t>(1) << shift_h;
+
+                    for (int i = 0; i < 16; ++i, src += src_step, dst += dst_step) {
+                        if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+                            *dst = src->getRGB();
+                        } else {
+                            *dst = *src;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+/// \brief Gathers the colors of a lutmap of fewer levels into a lattice of nodes
+/// \param pixels The lutmap, <tt>getLUTMapSize(levels)</tt> pixels square, row by row
+/// \param levels Number of levels of each channel, see \c isValidLUTMapLevels
+/// \param axis Axis channel of the lutmap: 0 for R, 1 for G, 2 for B
+/// \param nodes Receives <tt>levels ^ 3</tt> nodes, B index varies fastest, then G, then R, like the entries of a LUT cache
+/// \remark Tiles are laid out and flipped just like on a full lutmap, \c levels of them instead of 256
+inline void readLUTMapNodes(const Color* pixels, int levels, unsigned char axis, Color* nodes) noexcept {
+    const unsigned char h = (axis + 1) % 3;
+    const unsigned char v = (axis + 2) % 3;
+    const int tiles = getLUTMapTiles(levels);
+    const std::ptrdiff_t stride = getLUTMapSize(levels);
+
+    int index[3];
+    for (int stage = 0; stage < levels; ++stage) {
+        const bool h_flip = stage & 1;
+        const bool v_flip = (stage / tiles) & 1;
+        const Color* tile = pixels + (stage / tiles) * levels * stride + (stage % tiles) * levels;
+        index[axis] = stage;
+        for (int y = 0; y < levels; ++y) {
+            const Color* row = tile + (v_flip ? levels - 1 - y : y) * stride;
+            index[v] = y;
+            for (int x = 0; x < levels; ++x) {
+                index[h] = x;
+                nodes[(static_cast<std::size_t>(index[0]) * levels + index[1]) * levels + index[2]] = row[h_flip ? levels - 1 - x : x];
+            }
+        }
     }
-    const std::string axis_annot = Pathutils::getSecondaryExtensionName(input_file);
+}
 
-    // Default axis is B (put most quantization loss on B -- the least noticeable light component for the eye)
-    unsigned char axis = 2;
-    if (axis_annot == "r") {
-        axis = 0;
-    } else if (axis_annot == "g") {
-        axis = 1;
+/// \brief Fills a LUT cache by trilinear interpolation between the nodes of a lattice
+/// \param nodes <tt>levels ^ 3</tt> nodes at \c sampleSpan(0, 255, levels), B index varies fastest, then G, then R
+/// \param data LUT data cache of either \c Color or \c ColorRGB to be filled
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \remark Work is split along R, so every thread writes its own contiguous block. Interpolation is done one axis at a
+/// time: the plane of G x B nodes along R, then a row of B nodes along G, leaving a single lerp per channel per entry.
+template <typename EntryTy>
+void expandLUTMapNodes(const Color* nodes, int levels, EntryTy* data, ThreadPool* pool = nullptr) {
+    const int n = levels;
+    const std::vector<int> sample_points = sampleSpan(0, 255, n);
+    std::array<int, 256> cells {};
+    std::array<float, 256> weights {};
+    for (int v = 0, cell = 0; v < 256; ++v) {
+        while (cell < n - 2 && v > sample_points[cell + 1]) {
+            ++cell;
+        }
+        cells[v] = cell;
+        weights[v] = static_cast<float>(v - sample_points[cell]) / static_cast<float>(sample_points[cell + 1] - sample_points[cell]);
     }
 
-    Color* data = nullptr;
+    parallelFor(pool, 0, 256, 4, [&](std::size_t first, std::size_t last) {
+        // RGB of the G x B plane of nodes at this R, then of the row of B nodes at this G
+        std::vector<float> plane(static_cast<std::size_t>(n) * n * 3);
+        std::vector<float> row(static_cast<std::size_t>(n) * 3);
 
-    try // Touching pile memory in this block
-    {
-        data = new Color[LUT_RAW_DATA_SIZE] {};
+        for (std::size_t r = first; r < last; ++r) {
+            const float fr = weights[r];
+            const auto* lower = reinterpret_cast<const unsigned char*>(nodes + static_cast<std::size_t>(cells[r]) * n * n);
+            const unsigned char* upper = lower + static_cast<std::size_t>(n) * n * 4;
+            for (std::size_t i = 0; i < static_cast<std::size_t>(n) * n; ++i) {
+                for (std::size_t c = 0; c < 3; ++c) {
+                    const float low = lower[i * 4 + c];
+                    plane[i * 3 + c] = low + (static_cast<float>(upper[i * 4 + c]) - low) * fr;
+                }
+            }
 
-        // Not a hot function, so we just do this ugly loop :D
-        for (int r = 0; r < 256; ++r) {
+            EntryTy* out = data + (r << 16);
             for (int g = 0; g < 256; ++g) {
-                for (int b = 0; b < 256; ++b) {
-                    Color rgba {
-                        static_cast<unsigned char>(r),
-                        static_cast<unsigned char>(g),
-                        static_cast<unsigned char>(b),
-                        255
-                    };
-                    data[rgba.getHexRGB()] = map->at(rgbToMapPosition(rgba, axis, true));
+                const float fg = weights[g];
+                const float* low = plane.data() + static_cast<std::ptrdiff_t>(cells[g]) * n * 3;
+                const float* high = low + static_cast<std::ptrdiff_t>(n) * 3;
+                for (int i = 0; i < n * 3; ++i) {
+                    row[i] = low[i] + (high[i] - low[i]) * fg;
+                }
+
+                for (int b = 0; b < 256; ++b, ++out) {
+                    const float fb = weights[b];
+                    const float* node = row.data() + cells[b] * 3;
+                    unsigned char mapped[3];
+                    for (int c = 0; c < 3; ++c) {
+                        mapped[c] = static_cast<unsigned char>(node[c] + (node[3 + c] - node[c]) * fb + 0.5f);
+                    }
+                    if constexpr (LUT_LAYOUT_OF<EntryTy> == LutLayout::RGB24) {
+                        *out = { mapped[0], mapped[1], mapped[2] };
+                    } else {
+                        *out = { mapped[0], mapped[1], mapped[2], 255 };
+                    }
                 }
             }
         }
+    });
+}
+
+/// \brief Fills a LUT cache from a lutmap of any number of levels
+/// \param pixels The lutmap, <tt>getLUTMapSize(levels)</tt> pixels square, row by row
+/// \param axis Axis channel of the lutmap: 0 for R, 1 for G, 2 for B
+/// \param data LUT data cache of either \c Color or \c ColorRGB to be filled
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \param levels Number of levels of each channel, see \c isValidLUTMapLevels
+/// \remark A full lutmap is copied as is by \c readFullLUTMap, a lutmap of fewer levels is interpolated by \c expandLUTMapNodes
+template <typename EntryTy>
+void readLUTMap(const Color* pixels, unsigned char axis, EntryTy* data, ThreadPool* pool = nullptr, int levels = LUTMAP_FULL_LEVELS) {
+    if (levels == LUTMAP_FULL_LEVELS) {
+        readFullLUTMap(pixels, axis, data, pool);
+        return;
+    }
+    std::vector<Color> nodes(static_cast<std::size_t>(levels) * levels * levels);
+    readLUTMapNodes(pixels, levels, axis, nodes.data());
+    expandLUTMapNodes(nodes.data(), levels, data, pool);
+}
+
+/// \brief Fills a LUT cache from a lutmap of any number of levels
+/// \param map The lutmap, 4096 x 4096, 512 x 512 or 64 x 64
+template <typename EntryTy>
+void readLUTMap(const Image& map, unsigned char axis, EntryTy* data, ThreadPool* pool = nullptr) {
+    const int levels = getLUTMapShape(map.getWidth(), map.getHeight()).levels;
+    if (map.getWidth() != getLUTMapSize(levels)) {
+        throw std::runtime_error { "enlarged LUT map must be averaged back first, see loadLUTMap" };
+    }
+    readLUTMap(map.begin(), axis, data, pool, levels);
+}
+
+/// \brief Averages a row of \c K x \c K blocks of pixels into a row of pixels, rounding to nearest
+/// \param sums Scratch room for <tt>K * width * 4</tt> sums
+template <int K>
+void boxDownsampleRow(const Color* src, std::size_t src_stride, Color* dst, std::size_t width, std::uint16_t* sums) noexcept {
+    // Sum the K rows first, byte by byte, which vectorizes whatever the layout, then the K pixels of each block
+    const std::size_t n = width * K * 4;
+    const auto* row = reinterpret_cast<const unsigned char*>(src);
+    for (std::size_t i = 0; i < n; ++i) {
+        sums[i] = row[i];
+    }
+    for (int r = 1; r < K; ++r) {
+        row += src_stride * 4;
+        for (std::size_t i = 0; i < n; ++i) {
+            sums[i] = static_cast<std::uint16_t>(sums[i] + row[i]);
+        }
+    }
+
+    auto* out = reinterpret_cast<unsigned char*>(dst);
+    for (std::size_t i = 0; i < width * 4; ++i) {
+        const std::size_t x = i >> 2;
+        const std::size_t c = i & 3;
+        unsigned total = 0;
+        for (int j = 0; j < K; ++j) {
+            total += sums[(x * K + j) * 4 + c];
+        }
+        out[i] = static_cast<unsigned char>((total + K * K / 2) / (K * K));
+    }
+}
+
+/// \brief Averages every \c k x \c k block of pixels into one, rounding to nearest
+/// \param src <tt>count * k</tt> rows of <tt>width * k</tt> pixels, \c src_stride pixels apart
+/// \param k Factor from 1 to \c LUTMAP_MAX_SCALE
+/// \param dst Receives \c count rows of \c width pixels, row by row
+/// \param pool The pool to spread the rows across; runs on the calling thread if \c nullptr
+inline void boxDownsample(
+    const Color* src,
+    std::size_t src_stride,
+    int k,
+    Color* dst,
+    std::size_t width,
+    std::size_t count,
+    ThreadPool* pool = nullptr) {
+    parallelFor(pool, 0, count, 16, [=](std::size_t first, std::size_t last) {
+        std::vector<std::uint16_t> sums(width * static_cast<std::size_t>(k) * 4);
+        for (std::size_t y = first; y < last; ++y) {
+            const Color* block_row = src + y * k * src_stride;
+            Color* out = dst + y * width;
+            switch (k) {
+            case 1:
+                std::copy(block_row, block_row + width, out);
+                break;
+            case 2:
+                boxDownsampleRow<2>(block_row, src_stride, out, width, sums.data());
+                break;
+            case 3:
+                boxDownsampleRow<3>(block_row, src_stride, out, width, sums.data());
+                break;
+            case 4:
+                boxDownsampleRow<4>(block_row, src_stride, out, width, sums.data());
+                break;
+            default:
+                throw std::invalid_argument { "unsupported downsampling factor" };
+            }
+        }
+    });
+}
+
+
+/// \brief Largest radius \c denoiseLUTMap accepts
+inline static constexpr int LUTMAP_DENOISE_MAX_RADIUS = 32;
+
+/// \brief Blurs a tile of a lutmap, body of the versions \c denoiseLUTMap picks from
+/// \param origin Top-left pixel of the tile, its rows \c stride pixels apart
+/// \param n Width and height of the tile
+/// \param weights The <tt>2 * radius + 1</tt> taps of the Gaussian
+/// \param padded Scratch room for <tt>(n + 2 * radius) * n * 4</tt> floats
+/// \param tile Scratch room for <tt>n * n * 4</tt> floats
+LUTOOLS_KERNEL_BODY void denoiseLUTMapTileBody(
+    Color* origin,
+    std::size_t stride,
+    std::size_t n,
+    int radius,
+    const float* weights,
+    float* padded,
+    float* tile) noexcept {
+    // All 4 channels go side by side, so every pass is a run of multiply-adds over contiguous floats
+    const int taps = 2 * radius + 1;
+    const std::size_t row_floats = n * 4;
+    const std::size_t pad = static_cast<std::size_t>(radius) * 4;
+
+    // Along rows, each extended by radius pixels on both ends
+    for (std::size_t y = 0; y < n; ++y) {
+        const auto* src = reinterpret_cast<const unsigned char*>(origin + y * stride);
+        float* ext = padded;
+        for (std::size_t i = 0; i < row_floats; ++i) {
+            ext[pad + i] = src[i];
+        }
+        const float* first_px = ext + pad;
+        const float* last_px = ext + pad + row_floats - 4;
+        for (std::size_t j = 1; j <= static_cast<std::size_t>(radius); ++j) {
+            for (std::size_t c = 0; c < 4; ++c) {
+                ext[pad - j * 4 + c] = 2.0f * first_px[c] - first_px[j * 4 + c];
+                ext[pad + row_floats - 4 + j * 4 + c] = 2.0f * last_px[c] - *(last_px + c - j * 4);
+            }
+        }
+        float* out = tile + y * row_floats;
+        std::fill(out, out + row_floats, 0.0f);
+        for (int j = 0; j < taps; ++j) {
+            const float w = weights[j];
+            const float* in = ext + j * 4;
+            for (std::size_t i = 0; i < row_floats; ++i) {
+                out[i] += w * in[i];
+            }
+        }
+    }
 
-        // Write lut file if output path is given
-        if (!output_file.empty()) {
-            std::ofstream fout;
-            fout.open(output_file, std::ofstream::binary | std::ofstream::trunc);
-            if (!fout.is_open()) {
-                throw std::runtime_error { "unable to create LUT file" };
+    // Along columns, a whole row of the tile at a time, the tile extended by radius rows on both ends
+    const std::size_t rows_pad = static_cast<std::size_t>(radius);
+    std::copy(tile, tile + n * row_floats, padded + rows_pad * row_floats);
+    const float* top = padded + rows_pad * row_floats;
+    const float* bottom = padded + (n - 1 + rows_pad) * row_floats;
+    for (std::size_t j = 1; j <= rows_pad; ++j) {
+        float* above = padded + (rows_pad - j) * row_floats;
+        float* below = padded + (n - 1 + rows_pad + j) * row_floats;
+        for (std::size_t i = 0; i < row_floats; ++i) {
+            above[i] = 2.0f * top[i] - top[j * row_floats + i];
+            below[i] = 2.0f * bottom[i] - *(bottom + i - j * row_floats);
+        }
+    }
+    for (std::size_t y = 0; y < n; ++y) {
+        float* out = tile + y * row_floats;
+        std::fill(out, out + row_floats, 0.0f);
+        for (int j = 0; j < taps; ++j) {
+            const float w = weights[j];
+            const float* in = padded + (y + j) * row_floats;
+            for (std::size_t i = 0; i < row_floats; ++i) {
+                out[i] += w * in[i];
             }
-            fout.write(
-                reinterpret_cast<const char*>(data),
-                static_cast<std::streamsize>(LUT_RAW_DATA_SIZE * sizeof(Color)));
-            fout.close();
+        }
+        auto* dst = reinterpret_cast<unsigned char*>(origin + y * stride);
+        for (std::size_t i = 0; i < row_floats; ++i) {
+            dst[i] = static_cast<unsigned char>(std::clamp(out[i] + 0.5f, 0.0f, 255.0f));
         }
     }
-    catch (std::exception&) {
-        delete[] data;
-        throw;
+}
+
+/// \brief Signature shared by all versions of \c denoiseLUTMapTileBody
+using DenoiseTileKernel = void (*)(Color*, std::size_t, std::size_t, int, const float*, float*, float*) noexcept;
+
+/// \brief Baseline version of \c denoiseLUTMapTileBody
+inline void denoiseLUTMapTileBaseline(Color* origin, std::size_t stride, std::size_t n, int radius, const float* weights, float* padded, float* tile) noexcept {
+    denoiseLUTMapTileBody(origin, stride, n, radius, weights, padded, tile);
+}
+
+/// \brief AVX2 version of \c denoiseLUTMapTileBody
+LUTOOLS_TARGET_AVX2 inline void denoiseLUTMapTileAvx2(Color* origin, std::size_t stride, std::size_t n, int radius, const float* weights, float* padded, float* tile) noexcept {
+    denoiseLUTMapTileBody(origin, stride, n, radius, weights, padded, tile);
+}
+
+/// \brief AVX-512 version of \c denoiseLUTMapTileBody
+LUTOOLS_TARGET_AVX512 inline void denoiseLUTMapTileAvx512(Color* origin, std::size_t stride, std::size_t n, int radius, const float* weights, float* padded, float* tile) noexcept {
+    denoiseLUTMapTileBody(origin, stride, n, radius, weights, padded, tile);
+}
+
+/// \brief Blurs every tile of a lutmap on its own, to smooth out the noise a lossy app left
+/// \details A Gaussian of standard deviation <tt>radius / 2</tt>, cut off at \c radius, runs along rows then columns.
+/// Tiles hold unrelated colors on either side of a seam, so nothing is blurred across: past the edge of a tile, the tile
+/// is extended by point reflection (<tt>2 * edge - inside</tt>), which unlike a plain mirror leaves a linear ramp, the
+/// shape of an identity lutmap, exactly as it is right up to the seam.
+/// \param pixels The lutmap, <tt>getLUTMapSize(levels)</tt> pixels square, row by row
+/// \param radius Radius of the blur in pixels, from 1 to \c LUTMAP_DENOISE_MAX_RADIUS, and below \c levels
+/// \param pool The pool to spread the tiles across; runs on the calling thread if \c nullptr
+/// \param levels Number of levels of each channel, which is the width and height of a tile
+inline void denoiseLUTMap(Color* pixels, int radius, ThreadPool* pool = nullptr, int levels = LUTMAP_FULL_LEVELS) {
+    if (radius < 1 || radius > LUTMAP_DENOISE_MAX_RADIUS) {
+        throw std::invalid_argument { "denoise radius must be 1 to " + std::to_string(LUTMAP_DENOISE_MAX_RADIUS) };
+    }
+    if (radius >= levels) {
+        throw std::invalid_argument { "denoise radius must be below " + std::to_string(levels) + " for a lutmap of " + std::to_string(levels) + " levels" };
+    }
+    static const DenoiseTileKernel kernel = selectKernel<DenoiseTileKernel>(
+        denoiseLUTMapTileBaseline, denoiseLUTMapTileAvx2, denoiseLUTMapTileAvx512);
+
+    const int taps = 2 * radius + 1;
+    std::vector<float> weights(taps);
+    float weight_sum = 0.0f;
+    for (int j = 0; j < taps; ++j) {
+        const float d = static_cast<float>(j - radius) / (0.5f * static_cast<float>(radius));
+        weights[j] = std::exp(-0.5f * d * d);
+        weight_sum += weights[j];
+    }
+    for (float& w : weights) {
+        w /= weight_sum;
+    }
+
+    const auto n = static_cast<std::size_t>(levels);
+    const auto tiles = static_cast<std::size_t>(getLUTMapTiles(levels));
+    const std::size_t stride = n * tiles;
+    parallelFor(pool, 0, tiles * tiles, 1, [&](std::size_t first, std::size_t last) {
+        std::vector<float> padded((n + 2 * static_cast<std::size_t>(radius)) * n * 4);
+        std::vector<float> tile(n * n * 4);
+        for (std::size_t t = first; t < last; ++t) {
+            Color* origin = pixels + (t / tiles) * n * stride + (t % tiles) * n;
+            kernel(origin, stride, n, radius, weights.data(), padded.data(), tile.data());
+        }
+    });
+}
+
+/// \brief Pixels of a lutmap, at its original size
+struct LutMapPixels {
+    /// \brief <tt>getLUTMapSize(levels)</tt> pixels square, row by row
+    std::shared_ptr<Color> pixels;
+    /// \brief Number of levels of each channel, see \c isValidLUTMapLevels
+    int levels;
+};
+
+/// \brief Loads the pixels of a lutmap, averaging an enlarged one back to its original size
+/// \details A lutmap enlarged before going through a lossy app gets each block of k x k pixels averaged, which also
+/// smooths out most of the compression noise. Enlarged PNG, PPM and PAM lutmaps are decoded a band of rows at a time,
+/// so they are never in memory whole.
+/// \param input_file Path of the lutmap, of any size \c getLUTMapShape accepts
+/// \param pool The pool to spread averaging across; runs on the calling thread if \c nullptr
+/// \param denoise_radius Radius of \c denoiseLUTMap run on the result, 0 not to
+inline LutMapPixels loadLUTMap(const std::string& input_file, ThreadPool* pool = nullptr, int denoise_radius = 0) {
+    LutMapPixels map {};
+
+    std::unique_ptr<RowReader> reader {};
+    try {
+        reader = openRowReader(input_file);
+    }
+    catch (std::exception&) {} // Let stb have a go, e.g. at interlaced PNGs
+    const LutMapShape shape = reader ? getLUTMapShape(reader->getWidth(), reader->getHeight()) : LutMapShape {};
+    if (reader && shape.scale > 1) {
+        const int k = shape.scale;
+        const auto size = static_cast<std::size_t>(getLUTMapSize(shape.levels));
+        const auto downsampled = std::make_shared<std::vector<Color>>(size * size);
+        const std::size_t band_rows = 64;
+        std::vector<Color> band(band_rows * k * size * k);
+        for (std::size_t y = 0; y < size; y += band_rows) {
+            reader->readRows(band.data(), band_rows * k);
+            boxDownsample(band.data(), size * k, k, downsampled->data() + y * size, size, band_rows, pool);
+        }
+        map = { { downsampled, downsampled->data() }, shape.levels };
+    } else {
+        reader.reset();
+        const auto image = std::make_shared<Image>(input_file);
+        const auto [levels, k] = getLUTMapShape(image->getWidth(), image->getHeight());
+        if (k == 1) {
+            map = { { image, image->begin() }, levels };
+        } else {
+            const auto size = static_cast<std::size_t>(getLUTMapSize(levels));
+            const auto downsampled = std::make_shared<std::vector<Color>>(size * size);
+            boxDownsample(image->begin(), size * k, k, downsampled->data(), size, size, pool);
+            map = { { downsampled, downsampled->data() }, levels };
+        }
+    }
+
+    if (denoise_radius) {
+        denoiseLUTMap(map.pixels.get(), denoise_radius, pool, map.levels);
+    }
+    return map;
+}
+
+/// \brief Analyzes a lutmap and cache the entire LUT, interpolation-free unless the lutmap holds fewer levels
+/// \tparam EntryTy \c Color for a plain RGBA cache, or \c ColorRGB for a compact one
+/// \param input_file Path of the lutmap, 4096 x 4096, 512 x 512 or 64 x 64, or enlarged up to 4 times, see \c loadLUTMap
+/// \param output_file Path of the output (.lut format); writing is skipped if empty
+/// \param pool The pool to spread the work across; runs on the calling thread if \c nullptr
+/// \param compression How to store the output, see \c saveCacheToFile
+/// \param denoise_radius Radius of \c denoiseLUTMap run on the lutmap first, 0 not to
+/// \return A table of \c LUT_ENTRY_COUNT \c EntryTy which stores the mapped value of all possible colors in the RGB colorspace; the mapped value can be accessed via index returned by \c Color::getHexRGB()
+/// \remark Ensures a valid table of \c EntryTy
+template <typename EntryTy = Color>
+[[nodiscard]] LutTable<EntryTy> cacheLUTMap(
+    const std::string& input_file,
+    const std::string& output_file,
+    ThreadPool* pool = nullptr,
+    LutCompression compression = LutCompression::None,
+    int denoise_radius = 0) {
+    const LutMapPixels map = loadLUTMap(input_file, pool, denoise_radius);
+    const std::string axis_annot = Pathutils::getSecondaryExtensionName(input_file);
+
+    // Default axis is B (put most quantization loss on B -- the least noticeable light component for the eye)
+    unsigned char axis = 2;
+    if (axis_annot == "r") {
+        axis = 0;
+    } else if (axis_annot == "g") {
+        axis = 1;
+    }
+
+    LutTable<EntryTy> data = allocateLutTable<EntryTy>();
+    readLUTMap(map.pixels.get(), axis, data.data(), pool, map.levels);
+
+    // Write lut file if output path is given, recording the lutmap so that a changed one gets the cache rebuilt
+    if (!output_file.empty()) {
+        const LutSource source = getLutSource(input_file, axis, pool);
+        saveCacheToFile(data.data(), output_file, pool, &source, compression);
     }
     return data;
 }
 
 /// \brief Loads a LUT cache into memory
-/// \param path Path of the input (.lut format)
-/// \return An array of \c Color which stores the mapped value of all possible colors in the RGB colorspace; the mapped value can be accessed via index returned by \c Color::getHexRGB()
-/// \remark Ensures a valid array of \c Color
-[[nodiscard]] inline Color* loadCacheFromFile(const std::string& path) {
-    Color* data = nullptr;
-
-    try // Touching pile memory in this block
-    {
-        data = new Color[LUT_RAW_DATA_SIZE] {};
-
-        // Load filter into buffer
-        std::ifstream fin;
-        fin.open(path, std::ifstream::binary);
-        if (!fin.is_open()) {
-            throw std::runtime_error {
-                std::string { "unable to open LUT file \"" } + path + "\""
-            };
-        }
-        fin.read(reinterpret_cast<char*>(data), LUT_RAW_DATA_SIZE * sizeof(Color));
-        if (fin.fail()) {
-            throw std::runtime_error { "invalid LUT file" };
+/// \param path Path of the input (.lut format), of any version and layout
+/// \param verify Whether to check the cache against the checksum in the file, if there is one
+/// \param pool The pool to spread decompression and verification across; runs on the calling thread if \c nullptr
+/// \return A table of \c Color which stores the mapped value of all possible colors in the RGB colorspace; the mapped value can be accessed via index returned by \c Color::getHexRGB()
+/// \remark Ensures a valid table of \c Color
+[[nodiscard]] inline LutTable<Color> loadCacheFromFile(const std::string& path, bool verify = true, ThreadPool* pool = nullptr) {
+    // Overwritten in full by a valid file, whatever the layout
+    LutTable<Color> table { LUT_RAW_DATA_SIZE };
+    Color* const data = table.data();
+
+    // Load filter into buffer
+    std::ifstream fin;
+    fin.open(path, std::ifstream::binary | std::ifstream::ate);
+    if (!fin.is_open()) {
+        throw std::runtime_error {
+            std::string { "unable to open LUT file \"" } + path + "\""
+        };
+    }
+    const auto file_size = static_cast<size_t>(fin.tellg());
+    unsigned char head[sizeof(LutFileHeader)] {};
+    fin.seekg(0);
+    fin.read(reinterpret_cast<char*>(head), static_cast<std::streamsize>(std::min(file_size, sizeof(head))));
+
+    LutFileHeader header;
+    fin.seekg(static_cast<std::streamoff>(parseCacheFileHeader(head, file_size, header)));
+    // Read the cache as stored, it fits in the buffer whatever the layout
+    std::vector<unsigned char> compressed(header.compression ? header.stored_size : 0);
+    fin.read(
+        header.compression ? reinterpret_cast<char*>(compressed.data()) : reinterpret_cast<char*>(data),
+        static_cast<std::streamsize>(header.stored_size));
+    if (fin.fail()) {
+        throw std::runtime_error { "invalid LUT file" };
+    }
+    fin.close();
+    if (header.compression) {
+        decodeCachePayload(header, compressed.data(), reinterpret_cast<unsigned char*>(data), pool);
+    }
+    if (verify) {
+        verifyCacheChecksum(header, reinterpret_cast<const unsigned char*>(data), pool);
+    }
+
+    if (header.layout == static_cast<std::uint8_t>(LutLayout::RGB24)) {
+        // Expand in place, from back to front
+        const auto* packed = reinterpret_cast<const ColorRGB*>(data);
+        for (size_t i = LUT_RAW_DATA_SIZE; i-- > 0;) {
+            const ColorRGB rgb = packed[i];
+            data[i] = { rgb.r, rgb.g, rgb.b, 255 };
         }
-        fin.close();
     }
-    catch (std::exception&) {
-        delete[] data;
-        throw;
+    return table;
+}
+
+/// \brief Decompresses the LUT cache of a compressed .lut file into memory
+template <typename EntryTy>
+std::shared_ptr<const EntryTy> decodeCacheFile(const LutFileHeader& header, const unsigned char* stored, bool verify, ThreadPool* pool) {
+    LutTable<EntryTy> data = allocateLutTable<EntryTy>();
+    decodeCachePayload(header, stored, reinterpret_cast<unsigned char*>(data.data()), pool);
+    if (verify) {
+        verifyCacheChecksum(header, reinterpret_cast<const unsigned char*>(data.data()), pool);
     }
-    return data;
+    return std::move(data).share();
+}
+
+/// \brief Maps a LUT cache into memory, read-only, instead of loading it
+/// \param path Path of the input (.lut format), of any version and layout
+/// \param verify Whether to check the cache against the checksum in the file, if there is one, which reads all of it
+/// \param pool The pool to spread decompression and verification across; runs on the calling thread if \c nullptr
+/// \return A view of the cache in the layout stored in the file, which keeps the mapping alive
+/// \remark Only the pages being touched are ever read, and they are shared among all processes mapping the same file.
+/// A compressed cache can't be mapped, it is decompressed into memory instead.
+[[nodiscard]] inline LutView mapCacheFile(const std::string& path, bool verify = false, ThreadPool* pool = nullptr) {
+    auto file = std::make_shared<MappedFile>(path);
+    LutFileHeader header;
+    const size_t offset = parseCacheFileHeader(file->data(), file->size(), header);
+    const unsigned char* data = file->data() + offset;
+    if (header.compression) {
+        return header.layout == static_cast<std::uint8_t>(LutLayout::RGB24)
+            ? LutView { decodeCacheFile<ColorRGB>(header, data, verify, pool) }
+            : LutView { decodeCacheFile<Color>(header, data, verify, pool) };
+    }
+    if (verify) {
+        verifyCacheChecksum(header, data, pool);
+    }
+    if (header.layout == static_cast<std::uint8_t>(LutLayout::RGB24)) {
+        return std::shared_ptr<const ColorRGB> { std::move(file), reinterpret_cast<const ColorRGB*>(data) };
+    }
+    return std::shared_ptr<const Color> { std::move(file), reinterpret_cast<const Color*>(data) };
 }
 }
 
-#endif // _LUT_HPP_
+#endif // _LUT_HPP_
\ No newline at end of file
@@ -0,0 +1,183 @@
+// Created: 2026-10-16
+
+#ifndef _LUT_CACHE_HPP_
+#define _LUT_CACHE_HPP_
+
+#include "color.hpp"
+#include "cube.hpp"
+#include "lut.hpp"
+#include "pathutils.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+namespace Lutools {
+
+/// \brief Default memory budget of a \c LutCache, room for 21 compact or 16 RGBA LUT caches
+inline static constexpr std::size_t LUT_CACHE_DEFAULT_BUDGET = static_cast<std::size_t>(1) << 30;
+
+/// \brief Loads a LUT the way the CLI does: a \c .cube is expanded, an up-to-date \c .lut next to a lutmap is mapped,
+/// otherwise the lutmap is processed and its \c .lut saved
+/// \param lut_file Path of a \c .lut, a lutmap or a \c .cube file
+/// \param pool The pool to build caches with; runs on the calling thread if \c nullptr
+inline LutView openLUT(const std::string& lut_file, ThreadPool* pool = nullptr) {
+    if (Pathutils::getExtensionName(lut_file) == "cube") {
+        return cacheCubeFile<ColorRGB>(lut_file, "", CubeInterpolation::Trilinear, pool);
+    }
+    const std::string raw_file = Pathutils::getExtensionNameRemoved(lut_file) + ".lut";
+    if (isCacheFileUpToDate(raw_file, lut_file, pool)) {
+        return mapCacheFile(raw_file);
+    }
+    return cacheLUTMap<ColorRGB>(lut_file, raw_file, pool);
+}
+
+/// \brief Thread-safe cache of loaded LUTs, keyed by path and modification time, within a memory budget
+/// \details Handles are \c LutView, sharing the ownership of the LUT cache, so a table stays valid for as long as
+/// anyone holds it. When the budget is exceeded, the least recently used tables nobody holds are dropped; tables in use
+/// are never dropped, so the cache may stay over budget while they are held. Concurrent requests of a table being
+/// loaded wait for that single load. A file modified since it was loaded is loaded again.
+class LutCache {
+    struct Entry {
+        std::string path;
+        std::filesystem::file_time_type modified;
+        LutView lut;
+        std::size_t bytes;
+    };
+
+    std::size_t _budget;
+    ThreadPool* _pool;
+
+    mutable std::mutex _mutex;
+    std::list<Entry> _entries; // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+    std::unordered_map<std::string, std::shared_future<LutView>> _loading;
+    std::size_t _resident_bytes = 0;
+    std::uint64_t _hits = 0;
+    std::uint64_t _misses = 0;
+
+    static std::filesystem::file_time_type getModifiedTime(const std::string& path) noexcept {
+        std::error_code ec;
+        const auto modified = std::filesystem::last_write_time(path, ec);
+        return ec ? std::filesystem::file_time_type::min() : modified;
+    }
+
+    void erase(std::list<Entry>::iterator it) noexcept {
+        _resident_bytes -= it->bytes;
+        _index.erase(it->path);
+        _entries.erase(it);
+    }
+
+    /// \brief Drops the least recently used tables nobody else holds until within budget
+    void shrink() noexcept {
+        for (auto it = _entries.end(); _resident_bytes > _budget && it != _entries.begin();) {
+            --it;
+            if (it->lut.getUseCount() == 1) {
+                erase(it++);
+            }
+        }
+    }
+
+public:
+    /// \brief Cache figures, as returned by \c getStats
+    struct Stats {
+        std::uint64_t hits; ///< Requests served without loading, including those waiting for another's load
+        std::uint64_t misses; ///< Requests that loaded a table
+        std::size_t resident_luts;
+        std::size_t resident_bytes;
+    };
+
+    /// \param budget Memory budget in bytes
+    /// \param pool The pool to build caches with; runs on the calling thread if \c nullptr
+    explicit LutCache(std::size_t budget = LUT_CACHE_DEFAULT_BUDGET, ThreadPool* pool = nullptr):
+        _budget(budget),
+        _pool(pool) {}
+
+    LutCache(const LutCache&) = delete;
+    LutCache& operator=(const LutCache&) = delete;
+
+    /// \brief Returns the LUT of a file, loading it with \c openLUT unless it is cached and up to date
+    /// \param lut_file Path of a \c .lut, a lutmap or a \c .cube file
+    /// \throw std::runtime_error If loading fails; the failure isn't cached
+    LutView get(const std::string& lut_file) {
+        const auto modified = getModifiedTime(lut_file);
+
+        std::unique_lock<std::mutex> lk { _mutex };
+        const auto found = _index.find(lut_file);
+        if (found != _index.end()) {
+            if (found->second->modified == modified) {
+                _entries.splice(_entries.begin(), _entries, found->second);
+                ++_hits;
+                return found->second->lut;
+            }
+            erase(found->second);
+        }
+
+        const auto loading = _loading.find(lut_file);
+        if (loading != _loading.end()) {
+            std::shared_future<LutView> pending = loading->second;
+            ++_hits;
+            lk.unlock();
+            return pending.get();
+        }
+
+        std::promise<LutView> promise;
+        _loading.emplace(lut_file, promise.get_future().share());
+        ++_misses;
+        lk.unlock();
+
+        LutView lut {};
+        try {
+            lut = openLUT(lut_file, _pool);
+        }
+        catch (std::exception&) {
+            lk.lock();
+            _loading.erase(lut_file);
+            lk.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        lk.lock();
+        _loading.erase(lut_file);
+        _entries.push_front({ lut_file, modified, lut, getLutPayloadSize(lut.getLayout()) });
+        _index[lut_file] = _entries.begin();
+        _resident_bytes += _entries.front().bytes;
+        shrink();
+        lk.unlock();
+
+        promise.set_value(lut);
+        return lut;
+    }
+
+    /// \brief Returns hit and miss counts, and what is resident
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lk { _mutex };
+        return { _hits, _misses, _entries.size(), _resident_bytes };
+    }
+
+    /// \brief Drops every table nobody else holds
+    void clear() {
+        std::lock_guard<std::mutex> lk { _mutex };
+        for (auto it = _entries.begin(); it != _entries.end();) {
+            if (it->lut.getUseCount() == 1) {
+                erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+}
+
+#endif // _LUT_CACHE_HPP_
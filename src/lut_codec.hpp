@@ -0,0 +1,252 @@
+// Created: 2026-10-16
+
+#ifndef _LUT_CODEC_HPP_
+#define _LUT_CODEC_HPP_
+
+#include "deflate.hpp"
+#include "inflate.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Encoding of the LUT cache stored in a .lut file
+enum class LutCompression : unsigned char {
+    /// \brief Stored as is, ready to be mapped
+    None = 0,
+    /// \brief Sliced, predicted and deflated by \c compressLutPayload
+    DeltaDeflate = 1
+};
+
+/// \brief Number of entries of each independently compressed slice of a LUT cache: one R plane of 256 x 256 entries
+inline static constexpr std::size_t LUT_SLICE_ENTRIES = static_cast<std::size_t>(1) << 16;
+
+#pragma region Slice coding
+
+/// \brief Replaces a plane of a slice with its residuals from the gradient predictor <tt>left + up - upleft</tt>, left
+/// being the neighbor along B and up the one along G, which leaves zeros wherever the LUT is locally linear
+/// \details Row 0 is predicted from the left only, column 0 from above only.
+/// \param plane The channel of every entry of the slice, rows of 256 entries
+/// \param residuals Receives \c count residuals
+inline void predictLutPlane(const unsigned char* plane, unsigned char* residuals, std::size_t count) noexcept {
+    for (std::size_t row = 0; row < count; row += 256) {
+        const std::size_t width = std::min<std::size_t>(256, count - row);
+        const unsigned char* cur = plane + row;
+        unsigned char* out = residuals + row;
+        if (!row) {
+            out[0] = cur[0];
+            for (std::size_t j = 1; j < width; ++j) {
+                out[j] = static_cast<unsigned char>(cur[j] - cur[j - 1]);
+            }
+            continue;
+        }
+        const unsigned char* up = cur - 256;
+        out[0] = static_cast<unsigned char>(cur[0] - up[0]);
+        for (std::size_t j = 1; j < width; ++j) {
+            out[j] = static_cast<unsigned char>(cur[j] - cur[j - 1] - up[j] + up[j - 1]);
+        }
+    }
+}
+
+/// \brief Undoes \c predictLutPlane in place
+/// \details The residuals of a row are the differences along B of the row minus the one above, so a running sum
+/// along the row then adding the row above restores it; only the running sum is serial.
+inline void unpredictLutPlane(unsigned char* plane, std::size_t count) noexcept {
+    for (std::size_t row = 0; row < count; row += 256) {
+        const std::size_t width = std::min<std::size_t>(256, count - row);
+        unsigned char* cur = plane + row;
+        for (std::size_t j = 1; j < width; ++j) {
+            cur[j] = static_cast<unsigned char>(cur[j] + cur[j - 1]);
+        }
+        if (row) {
+            const unsigned char* up = cur - 256;
+            for (std::size_t j = 0; j < width; ++j) {
+                cur[j] = static_cast<unsigned char>(cur[j] + up[j]);
+            }
+        }
+    }
+}
+
+/// \brief Appends residuals as runs of zeros, each a LEB128 length followed by the nonzero byte ending it
+/// \details Residuals are mostly zeros, which would otherwise go through deflate's byte-by-byte match copies on
+/// decoding; the trailing run has no byte after it.
+inline void encodeZeroRuns(const unsigned char* residuals, std::size_t count, std::vector<unsigned char>& out) {
+    for (std::size_t i = 0; i <= count;) {
+        std::size_t run = 0;
+        while (i + run < count && !residuals[i + run]) {
+            ++run;
+        }
+        i += run;
+        do {
+            out.push_back(static_cast<unsigned char>((run & 0x7f) | (run > 0x7f ? 0x80 : 0)));
+            run >>= 7;
+        } while (run);
+        if (i == count) {
+            break;
+        }
+        out.push_back(residuals[i++]);
+    }
+}
+
+/// \brief Expands the output of \c encodeZeroRuns
+/// \return Whether \c runs held exactly \c count residuals
+inline bool decodeZeroRuns(const unsigned char* runs, std::size_t size, unsigned char* residuals, std::size_t count) noexcept {
+    const unsigned char* const end = runs + size;
+    for (std::size_t i = 0;;) {
+        std::size_t run = 0;
+        for (int shift = 0;; shift += 7) {
+            if (runs == end || shift > 28) {
+                return false;
+            }
+            run |= static_cast<std::size_t>(*runs & 0x7f) << shift;
+            if (!(*runs++ & 0x80)) {
+                break;
+            }
+        }
+        if (run > count - i) {
+            return false;
+        }
+        std::memset(residuals + i, 0, run);
+        i += run;
+        if (i == count) {
+            return runs == end;
+        }
+        if (runs == end) {
+            return false;
+        }
+        residuals[i++] = *runs++;
+    }
+}
+
+#pragma endregion
+
+/// \brief Compresses a LUT cache, one slice at a time across a thread pool
+/// \details Each slice of \c LUT_SLICE_ENTRIES entries (the last one also takes whatever entries are left, e.g. the spare
+/// entry of a compact cache) is split into channel planes, each plane replaced with its residuals by
+/// \c predictLutPlane, the zero runs of which are collapsed by \c encodeZeroRuns before being deflated on their own.
+/// Smooth LUTs leave mostly zeros, which shrink to almost nothing. The result starts with the number of slices
+/// (32 bits), then the end offset of each compressed slice (64 bits each, counted from after the offset table), then
+/// the slices back to back.
+/// \param payload The LUT cache, \c size bytes
+/// \param entry_size Size of an entry in bytes, 3 or 4
+/// \param pool The pool to spread the slices across; runs on the calling thread if \c nullptr
+inline std::vector<unsigned char> compressLutPayload(const unsigned char* payload, std::size_t size, std::size_t entry_size, ThreadPool* pool = nullptr) {
+    const std::size_t entries = size / entry_size;
+    const std::size_t slices = std::max<std::size_t>(1, entries / LUT_SLICE_ENTRIES);
+
+    std::vector<std::vector<unsigned char>> compressed(slices);
+    parallelFor(pool, 0, slices, 1, [&](std::size_t first, std::size_t last) {
+        DeflateEncoder encoder {};
+        std::vector<unsigned char> plane;
+        std::vector<unsigned char> residuals;
+        std::vector<unsigned char> runs;
+        for (std::size_t s = first; s < last; ++s) {
+            const std::size_t begin = s * LUT_SLICE_ENTRIES;
+            const std::size_t count = (s == slices - 1 ? entries : begin + LUT_SLICE_ENTRIES) - begin;
+            const unsigned char* src = payload + begin * entry_size;
+            plane.resize(count);
+            residuals.resize(count * entry_size);
+            for (std::size_t c = 0; c < entry_size; ++c) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    plane[i] = src[i * entry_size + c];
+                }
+                predictLutPlane(plane.data(), residuals.data() + c * count, count);
+            }
+            runs.clear();
+            encodeZeroRuns(residuals.data(), residuals.size(), runs);
+            encoder.compress(runs.data(), 0, runs.size(), true, compressed[s]);
+        }
+    });
+
+    const auto slice_count = static_cast<std::uint32_t>(slices);
+    std::vector<unsigned char> result(sizeof(slice_count) + slices * sizeof(std::uint64_t));
+    std::memcpy(result.data(), &slice_count, sizeof(slice_count));
+    std::uint64_t end = 0;
+    for (std::size_t s = 0; s < slices; ++s) {
+        end += compressed[s].size();
+        std::memcpy(result.data() + sizeof(slice_count) + s * sizeof(end), &end, sizeof(end));
+    }
+    result.reserve(result.size() + end);
+    for (const std::vector<unsigned char>& slice : compressed) {
+        result.insert(result.end(), slice.begin(), slice.end());
+    }
+    return result;
+}
+
+/// \brief Decompresses a LUT cache compressed by \c compressLutPayload, one slice at a time across a thread pool
+/// \param stored The compressed data, \c stored_size bytes
+/// \param payload Receives the LUT cache, \c size bytes
+/// \param entry_size Size of an entry in bytes, 3 or 4
+/// \param pool The pool to spread the slices across; runs on the calling thread if \c nullptr
+/// \throw std::runtime_error If the compressed data is corrupt
+inline void decompressLutPayload(
+    const unsigned char* stored,
+    std::size_t stored_size,
+    unsigned char* payload,
+    std::size_t size,
+    std::size_t entry_size,
+    ThreadPool* pool = nullptr) {
+    const std::size_t entries = size / entry_size;
+    const std::size_t slices = std::max<std::size_t>(1, entries / LUT_SLICE_ENTRIES);
+
+    std::uint32_t slice_count = 0;
+    const std::size_t table_size = sizeof(slice_count) + slices * sizeof(std::uint64_t);
+    if (stored_size >= sizeof(slice_count)) {
+        std::memcpy(&slice_count, stored, sizeof(slice_count));
+    }
+    if (slice_count != slices || stored_size < table_size) {
+        throw std::runtime_error { "invalid compressed LUT file" };
+    }
+    std::vector<std::uint64_t> ends(slices);
+    std::memcpy(ends.data(), stored + sizeof(slice_count), slices * sizeof(std::uint64_t));
+    for (std::size_t s = 0; s < slices; ++s) {
+        if (ends[s] < (s ? ends[s - 1] : 0) || ends[s] > stored_size - table_size) {
+            throw std::runtime_error { "invalid compressed LUT file" };
+        }
+    }
+
+    parallelFor(pool, 0, slices, 1, [&](std::size_t first, std::size_t last) {
+        std::vector<unsigned char> runs;
+        std::vector<unsigned char> residuals;
+        for (std::size_t s = first; s < last; ++s) {
+            const std::size_t begin = s * LUT_SLICE_ENTRIES;
+            const std::size_t count = (s == slices - 1 ? entries : begin + LUT_SLICE_ENTRIES) - begin;
+            const unsigned char* in = stored + table_size + (s ? ends[s - 1] : 0);
+            std::size_t in_left = static_cast<std::size_t>(ends[s] - (s ? ends[s - 1] : 0));
+
+            Inflater inflater { [&](unsigned char* buffer, std::size_t n) {
+                n = std::min(n, in_left);
+                std::memcpy(buffer, in, n);
+                in += n;
+                in_left -= n;
+                return n;
+            } };
+            // Runs take at most a length byte per residual, plus the trailing run
+            runs.resize(2 * count * entry_size + 8);
+            runs.resize(inflater.read(runs.data(), runs.size()));
+            residuals.resize(count * entry_size);
+            if (!inflater.isDone() || !decodeZeroRuns(runs.data(), runs.size(), residuals.data(), residuals.size())) {
+                throw std::runtime_error { "invalid compressed LUT file" };
+            }
+
+            // Undo the prediction plane by plane, then interleave the channels back
+            unsigned char* dst = payload + begin * entry_size;
+            for (std::size_t c = 0; c < entry_size; ++c) {
+                unsigned char* plane = residuals.data() + c * count;
+                unpredictLutPlane(plane, count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    dst[i * entry_size + c] = plane[i];
+                }
+            }
+        }
+    });
+}
+}
+
+#endif // _LUT_CODEC_HPP_
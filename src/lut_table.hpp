@@ -0,0 +1,112 @@
+// Created: 2026-10-16
+
+#ifndef _LUT_TABLE_HPP_
+#define _LUT_TABLE_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace Lutools {
+
+/// \brief Alignment of the storage of a \c LutTable, that of a transparent huge page on x86-64
+inline static constexpr std::size_t LUT_TABLE_ALIGNMENT = static_cast<std::size_t>(2) << 20;
+
+/// \brief Owning array of LUT cache entries, left uninitialized
+/// \details A LUT cache is filled in full right after being allocated, so zeroing it first would only double the page
+/// faults. The storage is aligned for huge pages, which Linux is asked to back it with, so that lookups scattered over
+/// the table miss the TLB less; pages are then faulted in by whichever thread fills them first.
+/// \tparam EntryTy \c Color or \c ColorRGB
+template <typename EntryTy>
+class LutTable {
+    static_assert(std::is_trivially_default_constructible_v<EntryTy> && std::is_trivially_destructible_v<EntryTy>,
+        "LutTable entries must be trivial");
+
+    EntryTy* _data = nullptr;
+    std::size_t _size = 0;
+
+    static void deallocate(const EntryTy* data) noexcept {
+        ::operator delete(const_cast<EntryTy*>(data), std::align_val_t { LUT_TABLE_ALIGNMENT });
+    }
+
+    void free() noexcept {
+        if (_data) {
+            deallocate(_data);
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+
+public:
+#pragma region Move-only
+
+    LutTable(const LutTable&) = delete;
+
+    LutTable& operator=(const LutTable&) = delete;
+
+    LutTable(LutTable&& src) noexcept:
+        _data(src._data),
+        _size(src._size) {
+        src._data = nullptr;
+        src._size = 0;
+    }
+
+    LutTable& operator=(LutTable&& src) noexcept {
+        if (this != &src) {
+            free();
+            _data = src._data;
+            _size = src._size;
+            src._data = nullptr;
+            src._size = 0;
+        }
+        return *this;
+    }
+
+#pragma endregion
+
+    LutTable() = default;
+
+    /// \brief Allocates room for \c size entries, without initializing them
+    /// \throw std::bad_alloc If out of memory
+    explicit LutTable(std::size_t size):
+        _data(static_cast<EntryTy*>(::operator new(size * sizeof(EntryTy), std::align_val_t { LUT_TABLE_ALIGNMENT }))),
+        _size(size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        madvise(_data, size * sizeof(EntryTy), MADV_HUGEPAGE); // Merely a hint, failing is fine
+#endif
+    }
+
+    ~LutTable() {
+        free();
+    }
+
+    /// \brief Returns the first entry
+    EntryTy* data() noexcept { return _data; }
+    /// \brief Returns the first entry
+    const EntryTy* data() const noexcept { return _data; }
+    /// \brief Returns the number of entries
+    std::size_t size() const noexcept { return _size; }
+
+    EntryTy& operator[](std::size_t i) noexcept { return _data[i]; }
+    const EntryTy& operator[](std::size_t i) const noexcept { return _data[i]; }
+
+    /// \brief Checks if anything is owned
+    explicit operator bool() const noexcept { return _data; }
+
+    /// \brief Hands the entries over to a shared owner, leaving this table empty
+    std::shared_ptr<const EntryTy> share() && {
+        // Let go first, the shared pointer frees the entries even if it fails to allocate its control block
+        const EntryTy* data = _data;
+        _data = nullptr;
+        _size = 0;
+        return { data, &LutTable::deallocate };
+    }
+};
+}
+
+#endif // _LUT_TABLE_HPP_
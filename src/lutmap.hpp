@@ -0,0 +1,113 @@
+// Created: 2026-10-16
+
+#ifndef _LUTMAP_HPP_
+#define _LUTMAP_HPP_
+
+#include "color.hpp"
+#include "image.hpp"
+#include "lut.hpp"
+#include "png.hpp"
+#include "stream_apply.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Fills rows of an identity lutmap, i.e. every color at the position \c rgbToMapPosition maps it to
+/// \param rows Receives \c count rows of <tt>getLUTMapSize(levels) * scale</tt> pixels
+/// \param first_row Index of the first row to fill
+/// \param axis Axis channel, whose value enumerates, tile by tile, throughout the entire lutmap: 0 for R, 1 for G, 2 for B
+/// \param scale Size multiplier, each pixel of the lutmap becoming \c scale x \c scale pixels
+/// \param pool The pool to spread the rows across; runs on the calling thread if \c nullptr
+/// \param levels Number of levels of each channel, see \c isValidLUTMapLevels; the levels are \c sampleSpan(0, 255, levels)
+inline void fillLUTMapRows(
+    Color* rows,
+    int first_row,
+    int count,
+    unsigned char axis,
+    int scale = 1,
+    ThreadPool* pool = nullptr,
+    int levels = LUTMAP_FULL_LEVELS) {
+    const unsigned char h = (axis + 1) % 3;
+    const unsigned char v = (axis + 2) % 3;
+    const int tiles = getLUTMapTiles(levels);
+    const std::size_t width = static_cast<std::size_t>(getLUTMapSize(levels)) * scale;
+    const std::vector<int> values = sampleSpan(0, 255, levels);
+
+    parallelFor(pool, 0, static_cast<std::size_t>(count), 1, [&, width](std::size_t first, std::size_t last) {
+        // Every row of a tile is the same run of values of h, reversed on odd tiles, so build both once
+        std::vector<unsigned char> h_run[2] { std::vector<unsigned char>(levels), std::vector<unsigned char>(levels) };
+        for (int i = 0; i < levels; ++i) {
+            h_run[0][i] = static_cast<unsigned char>(values[i]);
+            h_run[1][i] = static_cast<unsigned char>(values[levels - 1 - i]);
+        }
+
+        for (std::size_t r = first; r < last; ++r) {
+            const int y = (first_row + static_cast<int>(r)) / scale;
+            const int quot = y / levels;
+            const int rem = y % levels;
+            Color entry { 0, 0, 0, 255 };
+            unsigned char* channels = &entry.r;
+            channels[v] = static_cast<unsigned char>(values[quot & 1 ? levels - 1 - rem : rem]);
+
+            Color* out = rows + r * width;
+            for (int stage = quot * tiles; stage < (quot + 1) * tiles; ++stage) {
+                channels[axis] = static_cast<unsigned char>(values[stage]);
+                const unsigned char* run = h_run[stage & 1].data();
+                for (int i = 0; i < levels; ++i) {
+                    channels[h] = run[i];
+                    for (int k = 0; k < scale; ++k) {
+                        *out++ = entry;
+                    }
+                }
+            }
+        }
+    });
+}
+
+/// \brief Generates an identity lutmap, the image to be processed by a filter so that LUTools can rip it
+/// \details The image is generated and encoded a row of tiles at a time, so it is never in memory as a whole.
+/// \param output_file Path of the output, a PNG, PPM or PAM file; name it \c *.r.png or \c *.g.png for the R and G axes
+/// \param axis Axis channel, whose value enumerates, tile by tile, throughout the entire lutmap: 0 for R, 1 for G, 2 for B
+/// \param scale Size multiplier from 1 to \c LUTMAP_MAX_SCALE, each pixel becoming \c scale x \c scale pixels
+/// \param pool The pool to spread generation and encoding across; runs on the calling thread if \c nullptr
+/// \param png_effort Trade-off between PNG file size and encoding speed
+/// \param levels Number of levels of each channel, see \c isValidLUTMapLevels, e.g. 64 for a 512 x 512 lutmap
+inline void generateLUTMap(
+    const std::string& output_file,
+    unsigned char axis = 2,
+    int scale = 1,
+    ThreadPool* pool = nullptr,
+    PngEffort png_effort = PngEffort::Fast,
+    int levels = LUTMAP_FULL_LEVELS) {
+    if (axis > 2) {
+        throw std::invalid_argument { "lutmap axis must be 0, 1 or 2" };
+    }
+    if (scale < 1 || scale > LUTMAP_MAX_SCALE) {
+        throw std::invalid_argument { "lutmap scale must be 1 to " + std::to_string(LUTMAP_MAX_SCALE) };
+    }
+    if (!isValidLUTMapLevels(levels)) {
+        throw std::invalid_argument { "lutmap levels must be 16, 64 or 256" };
+    }
+    const int size = getLUTMapSize(levels) * scale;
+    const std::unique_ptr<RowWriter> writer = openRowWriter(output_file, size, size, png_effort);
+    if (!writer) {
+        throw std::runtime_error { "unsupported lutmap format \"" + output_file + "\", expecting PNG, PPM or PAM" };
+    }
+
+    const int band_rows = levels * scale;
+    std::vector<Color> band(static_cast<std::size_t>(band_rows) * size);
+    for (int row = 0; row < size; row += band_rows) {
+        fillLUTMapRows(band.data(), row, band_rows, axis, scale, pool, levels);
+        writer->writeRows(band.data(), static_cast<std::size_t>(band_rows), pool);
+    }
+    writer->finish();
+}
+}
+
+#endif // _LUTMAP_HPP_
@@ -1,39 +1,352 @@
+#include "apply.hpp"
+#include "compose.hpp"
+#include "cpu.hpp"
 #include "cube.hpp"
+#include "lattice.hpp"
+#include "lut_cache.hpp"
+#include "lutmap.hpp"
 #include "pathutils.hpp"
-#include "thread_guard.hpp"
+#include "pipe.hpp"
+#include "pipeline.hpp"
+#include "server.hpp"
+#include "stream_apply.hpp"
+#include "thread_pool.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
 #include <thread>
-#include <shared_mutex>
-#include <vector>
 #include <utility>
+#include <vector>
+
+/// \brief Parses a whole commandline argument as a number, rejecting anything before or after it
+/// \return Whether \c text is a number \c NumTy holds; \c value is left untouched if not
+template <typename NumTy>
+static bool parseArgument(std::string_view text, NumTy& value) {
+    NumTy parsed {};
+    const char* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, parsed);
+    if (ec != std::errc {} || ptr != end) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
 
 /// \brief LUTools the commandline tool, also serves as a demonstration of usage
 int main(int argc, char** argv) {
     using namespace Lutools;
-    using namespace LutoolsCli;
     using namespace Pathutils;
 
+    const std::string program_name = getBaseName(argv[0]);
+
+    // Leading options, all of them come before the LUT
+    unsigned jobs = 0; // Hardware concurrency
+    int lattice_size = 0; // Apply with the full cache
+    PngEffort png_effort = PngEffort::Default;
+    bool png_effort_given = false;
+    FrameFormat frame_format {}; // Not piping unless set
+    std::string socket_path; // Not serving unless set
+    bool chaining = false;
+    bool generating = false;
+    float strength = 1.0f; // Full strength
+    LutCompression compression = LutCompression::None;
+    int denoise_radius = 0; // No denoising
+    int levels = LUTMAP_FULL_LEVELS;
+    while (argc >= 2 && argv[1][0] == '-') {
+        const std::string option { argv[1] };
+        if (option == "-cpu-features") {
+            // Diagnostic only, what the CPU has and which versions of the kernels run
+            const CpuFeatures& cpu = getCpuFeatures();
+            const std::pair<bool, const char*> features[] {
+                { cpu.sse2, "sse2" }, { cpu.sse41, "sse4.1" }, { cpu.avx2, "avx2" }, { cpu.fma, "fma" },
+                { cpu.avx512f, "avx512f" }, { cpu.avx512bw, "avx512bw" }
+            };
+            std::cout << "features:";
+            for (const auto& [present, name] : features) {
+                if (present) {
+                    std::cout << ' ' << name;
+                }
+            }
+            const CpuLevel supported = getSupportedCpuLevel(cpu);
+            std::cout << "\nkernels: " << getCpuLevelName(getCpuLevel());
+            if (getCpuLevel() != supported) {
+                std::cout << " (lowered by LUTOOLS_CPU from " << getCpuLevelName(supported) << ")";
+            }
+            std::cout << std::endl;
+            return 0;
+        } else if (option == "-j" && argc >= 3) {
+            // Digits only, from_chars takes no sign but stoul would wrap -1 around
+            const std::string_view value { argv[2] };
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), jobs);
+            if (ec != std::errc {} || end != value.data() + value.size() || jobs < 1 || jobs > THREAD_POOL_MAX_CONCURRENCY) {
+                std::cerr << "error: invalid number of jobs \"" << argv[2] << "\", expecting 1 to " << THREAD_POOL_MAX_CONCURRENCY << std::endl;
+                return 1;
+            }
+        } else if (option == "-engine" && argc >= 3) {
+            // full, lattice or lattice:SIZE
+            const std::string engine { argv[2] };
+            if (engine == "full") {
+                lattice_size = 0;
+            } else if (engine.compare(0, 7, "lattice") == 0) {
+                lattice_size = LATTICE_DEFAULT_SIZE;
+                if (engine.size() > 7) {
+                    // The size must be digits only, nothing before or after them
+                    const char* end = engine.data() + engine.size();
+                    const auto [ptr, ec] = std::from_chars(engine.data() + 8, end, lattice_size);
+                    if (engine[7] != ':' || ec != std::errc {} || ptr != end || engine[8] == '-') {
+                        lattice_size = 0;
+                    }
+                }
+                if (lattice_size < 2 || lattice_size > 256) {
+                    std::cerr << "error: invalid engine \"" << engine << "\"" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "error: unknown engine \"" << engine << "\"" << std::endl;
+                return 1;
+            }
+        } else if (option == "-png" && argc >= 3) {
+            const std::string effort { argv[2] };
+            if (effort == "fast") {
+                png_effort = PngEffort::Fast;
+            } else if (effort == "default") {
+                png_effort = PngEffort::Default;
+            } else {
+                std::cerr << "error: unknown PNG effort \"" << effort << "\"" << std::endl;
+                return 1;
+            }
+            png_effort_given = true;
+        } else if (option == "-pipe" && argc >= 3) {
+            try {
+                frame_format = parseFrameFormat(argv[2]);
+            }
+            catch (std::exception& e) {
+                std::cerr << "error: " << e.what() << std::endl;
+                return 1;
+            }
+        } else if (option == "-strength" && argc >= 3) {
+            if (!parseArgument(argv[2], strength) || !(strength >= 0.0f && strength <= 1.0f)) {
+                std::cerr << "error: invalid strength \"" << argv[2] << "\", expecting 0 to 1" << std::endl;
+                return 1;
+            }
+        } else if (option == "-denoise" && argc >= 3) {
+            if (!parseArgument(argv[2], denoise_radius) || denoise_radius < 1 || denoise_radius > LUTMAP_DENOISE_MAX_RADIUS) {
+                std::cerr << "error: invalid denoise radius \"" << argv[2] << "\", expecting 1 to " << LUTMAP_DENOISE_MAX_RADIUS << std::endl;
+                return 1;
+            }
+        } else if (option == "-levels" && argc >= 3) {
+            if (!parseArgument(argv[2], levels) || !isValidLUTMapLevels(levels)) {
+                std::cerr << "error: invalid lutmap levels \"" << argv[2] << "\", expecting 16, 64 or 256" << std::endl;
+                return 1;
+            }
+        } else if (option == "-serve" && argc >= 3) {
+            socket_path = argv[2];
+        } else if (option == "-compress") {
+            // A flag, eat the option alone
+            compression = LutCompression::DeltaDeflate;
+            ++argv;
+            --argc;
+            continue;
+        } else if (option == "-chain") {
+            // The LUTs to compose follow, eat the option alone
+            chaining = true;
+            ++argv;
+            --argc;
+            break;
+        } else if (option == "-generate") {
+            // The axis and the scale follow, eat the option alone
+            generating = true;
+            ++argv;
+            --argc;
+            break;
+        } else {
+            std::cerr << "error: unknown option \"" << option << "\"" << std::endl;
+            return 1;
+        }
+
+        // Eat the option and its value
+        ++++argv;
+        ----argc;
+    }
+
+    if (!socket_path.empty()) {
+        if (argc != 1) {
+            std::cerr << "error: -serve takes no LUT, requests name their own" << std::endl;
+            return 1;
+        }
+        ThreadPool pool { jobs };
+        try {
+            std::cout << "serving: " << socket_path << std::endl;
+            LutServer { socket_path, pool, LUT_CACHE_DEFAULT_BUDGET, png_effort }.run();
+        }
+        catch (std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (generating) {
+        // [r | g | b] [RESIZE] [-OUTPUT], every axis unless one is given
+        std::string axes = "bgr";
+        int scale = 1;
+        std::string output_file {};
+        int i = 1;
+        if (i < argc && (std::string { argv[i] } == "r" || std::string { argv[i] } == "g" || std::string { argv[i] } == "b")) {
+            axes = argv[i++];
+        }
+        if (i < argc && argv[i][0] != '-') {
+            if (!parseArgument(argv[i], scale) || scale < 1 || scale > LUTMAP_MAX_SCALE) {
+                std::cerr << "error: invalid lutmap scale \"" << argv[i] << "\", expecting 1 to " << LUTMAP_MAX_SCALE << std::endl;
+                return 1;
+            }
+            ++i;
+        }
+        if (i < argc && argv[i][0] == '-' && axes.size() == 1) {
+            output_file = std::string { argv[i++] }.substr(1);
+        }
+        if (i != argc) {
+            std::cerr << "error: -generate takes an optional axis, scale, then output given an axis" << std::endl;
+            return 1;
+        }
+
+        ThreadPool pool { jobs };
+        try {
+            for (const char axis_name : axes) {
+                // Named like the lutmaps shipped, the annotation tells the axis when the lutmap gets processed
+                std::string file = output_file;
+                if (file.empty()) {
+                    file = "lutmap" + std::to_string(getLUTMapSize(levels) * scale) + (axis_name == 'b' ? "" : std::string { '.', axis_name }) + ".png";
+                }
+                const auto axis = static_cast<unsigned char>(axis_name == 'r' ? 0 : axis_name == 'g' ? 1 : 2);
+                generateLUTMap(file, axis, scale, &pool, png_effort_given ? png_effort : PngEffort::Fast, levels);
+                std::cout << "generated: " << file << std::endl;
+            }
+        }
+        catch (std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (chaining) {
+        // LUTs, then an optional -OUTPUT
+        std::vector<std::string> chain_files {};
+        std::string output_file {};
+        for (int i = 1; i < argc; ++i) {
+            if (i == argc - 1 && argv[i][0] == '-') {
+                output_file = std::string { argv[i] }.substr(1);
+            } else {
+                chain_files.emplace_back(argv[i]);
+            }
+        }
+        if (chain_files.size() < 2) {
+            std::cerr << "error: -chain takes at least 2 LUTs" << std::endl;
+            return 1;
+        }
+        if (output_file.empty()) {
+            output_file = getExtensionNameRemoved(chain_files.front());
+            for (std::size_t i = 1; i < chain_files.size(); ++i) {
+                output_file += "+" + getBaseName(chain_files[i]);
+            }
+            output_file += ".lut";
+        }
+
+        ThreadPool pool { jobs };
+        try {
+            std::vector<LutView> chain {};
+            for (const std::string& file : chain_files) {
+                chain.push_back(openLUT(file, &pool));
+            }
+            static_cast<void>(composeLUTs<ColorRGB>(chain, output_file, &pool, compression));
+            std::cout << "generated: " << output_file << std::endl;
+        }
+        catch (std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
     if (argc < 2) {
-        std::cout << "usage: " << getBaseName(argv[0]) << " {LUT | LUT_MAP} [-cube [RESOLUTION]] [INPUT [-OUTPUT]]..." << std::endl;
+        std::cout << "usage: " << program_name << " [-j JOBS] [-engine {full | lattice[:SIZE]}] [-png {fast | default}] [-strength STRENGTH] [-compress] [-denoise RADIUS] {LUT | LUT_MAP | CUBE} [-cube [RESOLUTION]] [INPUT [-OUTPUT]]...\n"
+                  << "       " << program_name << " [-j JOBS] [-engine {full | lattice[:SIZE]}] [-strength STRENGTH] -pipe WxH:{rgb24 | rgba} {LUT | LUT_MAP | CUBE} < FRAMES > FRAMES\n"
+                  << "       " << program_name << " [-j JOBS] [-compress] -chain {LUT | LUT_MAP | CUBE}... [-OUTPUT]\n"
+                  << "       " << program_name << " [-j JOBS] [-png {fast | default}] -serve SOCKET\n"
+                  << "       " << program_name << " [-j JOBS] [-png {fast | default}] [-levels {16 | 64 | 256}] -generate [r | g | b] [RESIZE] [-OUTPUT]\n"
+                  << "       " << program_name << " -cpu-features" << std::endl;
         return 0;
     }
 
+    if (frame_format.width > 0 && argc != 2) {
+        std::cerr << "error: -pipe takes a LUT only, frames come from stdin" << std::endl;
+        return 1;
+    }
+
+    // Initialize thread pool, used for building caches and for applying LUTs in stripes
+    ThreadPool pool { jobs };
+
+    // When piping, stdout carries the frames, so messages go to stderr
+    const bool piping = frame_format.width > 0;
+    const bool cache_only = argc == 2 && !piping;
+    std::ostream& info = piping ? std::cerr : std::cout;
+
     std::string lut_file = argv[1];
-    Color* lut = nullptr;
+    LutView lut {};
 
     do {
         // We ultimately must have this
         const std::string raw_file = getExtensionNameRemoved(lut_file) + ".lut";
 
+        // Denoising works on the pixels of a lutmap, which neither a cube file nor a cache has
+        if (denoise_radius && (getExtensionName(lut_file) == "cube" || getExtensionName(lut_file) == "lut")) {
+            std::cerr << "error: -denoise needs a lutmap image as LUT" << std::endl;
+            return 1;
+        }
+
         try {
-            // If lut file exists, load it
-            if (isFileAvailable(raw_file)) {
-                if (argc == 2) { break; }
-                lut = loadCacheFromFile(raw_file); // If this throws, lut remains nullptr
+            // A cube file expands in milliseconds, so it is only cached when asked to
+            if (getExtensionName(lut_file) == "cube") {
+                lut = cacheCubeFile<ColorRGB>(lut_file, cache_only ? raw_file : "", CubeInterpolation::Trilinear, &pool, compression);
+                if (cache_only) {
+                    info << "generated: " << raw_file << std::endl;
+                    break;
+                }
+                // Exporting would overwrite the input
+                if (argc > 2 && std::string { argv[2] } == "-cube") {
+                    std::cerr << "error: LUT is already a cube file" << std::endl;
+                    return 1;
+                }
+                break;
+            }
+
+            // If lut file exists and its lutmap hasn't changed since, load it, unless asked to denoise the lutmap or to
+            // compress the file
+            const bool up_to_date = isCacheFileUpToDate(raw_file, lut_file, &pool);
+            const bool restore = up_to_date && raw_file != lut_file &&
+                                 (denoise_radius ||
+                                  (cache_only && compression != LutCompression::None &&
+                                   readCacheFileHeader(raw_file).compression != static_cast<std::uint8_t>(compression)));
+            if (up_to_date && !restore) {
+                if (cache_only) {
+                    // Nothing to build, check the cache is intact instead
+                    if (verifyCacheFile(raw_file, &pool)) {
+                        info << "verified: " << raw_file << std::endl;
+                    }
+                    break;
+                }
+                lut = mapCacheFile(raw_file);
             } else {
-                lut = cacheLUTMap(lut_file, raw_file); // If this throws, lut remains nullptr
-                std::cout << "generated: " << raw_file << std::endl;
+                // Compact layout, so that lookups touch a quarter less memory
+                lut = cacheLUTMap<ColorRGB>(lut_file, raw_file, &pool, compression, denoise_radius);
+                info << "generated: " << raw_file << std::endl;
             }
 
             // Determine whether a cube file is required
@@ -63,72 +376,173 @@ int main(int argc, char** argv) {
             }
         }
         catch (std::exception& e) {
-            delete[] lut;
             std::cerr << "error: " << e.what() << std::endl;
             return 1;
         }
     } while (false);
 
     // If this run is just to build a cache, here we're good to go
-    if (argc == 2) { return 0; }
+    if (argc == 2 && !piping) { return 0; }
+
+    // At partial strength, a single image is blended while it's remapped; anything more gets the strength baked into the
+    // LUT once, which costs about as much as blending a 16-megapixel image
+    const auto bake_strength = [&] {
+        return LutView { blendLUT<ColorRGB>(lut, strength, "", &pool) };
+    };
+    const bool single_image = !piping && (argc == 3 || (argc == 4 && argv[3][0] == '-'));
+    if (strength < 1.0f && (piping || lattice_size || !single_image)) {
+        try {
+            lut = bake_strength();
+        }
+        catch (std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        strength = 1.0f;
+    }
+
+    // Resample into a small lattice if it's the preferred engine
+    std::shared_ptr<const LatticeLut> lattice {};
+    if (lattice_size) {
+        lattice = std::make_shared<LatticeLut>(lut, lattice_size);
+    }
+
+    // Frames in from stdin, out to stdout, until the input ends
+    if (piping) {
+        setBinaryStdio();
+        try {
+            const std::size_t frames = lattice
+                ? pipeFrames(stdin, stdout, frame_format, *lattice, &pool)
+                : pipeFrames(stdin, stdout, frame_format, lut, &pool);
+            info << "piped: " << frames << " frames" << std::endl;
+        }
+        catch (std::exception& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
     // Eat the LUT-related 2 args, leaving only the input images
     ++++argv;
     ----argc;
 
-    // Use the lowest compression level, I don't think people would rely on us to compress files :D
-    stbi_write_png_compression_level = 5;
+    // Determine filenames
+    std::vector<std::pair<std::string, std::string>> files {};
+    for (int i = 0; i < argc; ++i) {
+        std::string input_file { argv[i] };
+        std::string output_file =
+            i < argc - 1 && argv[i + 1][0] == '-'
+                ? std::string { argv[++i] }.substr(1)
+                : getExtensionNameRemoved(input_file) + "_" + getBaseName(lut_file) + "." + getExtensionName(input_file);
+        files.emplace_back(std::move(input_file), std::move(output_file));
+    }
+
+    // Three stages: decoders -> apply (striped across the pool) -> encoders
+    // Encoding dominates, so it gets most of the threads, and big PNGs are encoded in bands across the pool as well;
+    // the bounded queues cap the images held in memory
+    struct Job {
+        std::size_t index;
+        std::unique_ptr<Image> img;
+    };
+    const std::size_t concurrency = pool.getConcurrency();
+    const std::size_t decoders = std::min(files.size(), std::max<std::size_t>(1, concurrency / 4));
+    const std::size_t encoders = std::min(files.size(), std::max<std::size_t>(1, concurrency - decoders));
+    BoundedQueue<Job> decoded { decoders };
+    BoundedQueue<Job> applied { encoders };
 
-    // Initialize thread pool
-    std::vector<ThreadGuard<std::thread>> workers {};
-    workers.reserve(argc);
     std::mutex cout_mutex {}; // Force threads access stdout in order
     std::mutex cerr_mutex {}; // Force threads access stderr in order
+    const auto report_error = [&](const std::exception& e) {
+        // Encountering any exception, give up this image
+        std::lock_guard<std::mutex> lk { cerr_mutex };
+        std::cerr << "error: " << e.what() << std::endl;
+    };
 
-    try {
-        // Assign jobs
-        for (int i = 0; i < argc; ++i) {
-            // Determine filenames
-            std::string input_file { argv[i] };
-            std::string output_file =
-                i < argc - 1 && argv[i + 1][0] == '-'
-                    ? std::string { argv[++i] }.substr(1)
-                    : getExtensionNameRemoved(input_file) + "_" + getBaseName(lut_file) + "." + getExtensionName(input_file);
-
-            workers.emplace_back(
-                [input_file = std::move(input_file), output_file = std::move(output_file), lut, &cout_mutex, &cerr_mutex] {
+    std::atomic<std::size_t> next_file { 0 };
+    std::atomic<std::size_t> running_decoders { decoders };
+    std::vector<std::thread> stage_threads {};
+    for (std::size_t i = 0; i < decoders; ++i) {
+        stage_threads.emplace_back([&] {
+            for (std::size_t index; (index = next_file++) < files.size();) {
+                try {
+                    const std::string& input_file = files[index].first;
+                    const std::string& output_file = files[index].second;
+
+                    // Huge images skip the pipeline, they are streamed a band at a time from input to output, unless
+                    // that's the same file, which opening the output would truncate before it's read
+                    std::unique_ptr<RowReader> reader {};
                     try {
-                        // Load image
-                        Image img { input_file };
-
-                        // Color replacement
-                        for (Color& px: img) {
-                            Color mapped = lut[px.getHexRGB()];
-                            mapped.a = px.a;
-                            px = mapped;
+                        if (!isSameFile(input_file, output_file)) {
+                            reader = openRowReader(input_file);
                         }
-
-                        // Write out
-                        img.save(output_file);
-                        std::lock_guard<std::mutex> lk { cout_mutex };
-                        std::cout << "saved: " << output_file << std::endl;
                     }
-                    catch (std::exception& e) {
-                        // Encountering any exception, terminate thread
-                        std::lock_guard<std::mutex> lk { cerr_mutex };
-                        std::cerr << "error: " << e.what() << std::endl;
+                    catch (std::exception&) {} // Let stb have a go, e.g. at interlaced PNGs
+                    if (reader && reader->getTotalPixels() >= STREAM_MIN_PIXELS) {
+                        const std::unique_ptr<RowWriter> writer =
+                            openRowWriter(output_file, reader->getWidth(), reader->getHeight(), png_effort);
+                        if (writer) {
+                            if (lattice) {
+                                applyLUT(*reader, *writer, *lattice, &pool);
+                            } else {
+                                // Bigger than what baking the strength costs
+                                applyLUT(*reader, *writer, strength < 1.0f ? bake_strength() : lut, &pool);
+                            }
+                            std::lock_guard<std::mutex> lk { cout_mutex };
+                            std::cout << "saved: " << output_file << std::endl;
+                            continue;
+                        }
                     }
-                });
-        }
+                    reader.reset();
+
+                    decoded.push({ index, std::make_unique<Image>(input_file) });
+                }
+                catch (std::exception& e) {
+                    report_error(e);
+                }
+            }
+            // The last decoder out tells the apply stage no more images are coming
+            if (--running_decoders == 0) {
+                decoded.close();
+            }
+        });
     }
-    catch (std::exception& e) {
-        std::lock_guard<std::mutex> lk { cerr_mutex };
-        std::cerr << "error: " << e.what() << std::endl;
+    for (std::size_t i = 0; i < encoders; ++i) {
+        stage_threads.emplace_back([&] {
+            for (Job job; applied.pop(job);) {
+                try {
+                    const std::string& output_file = files[job.index].second;
+                    job.img->save(output_file, &pool, png_effort);
+                    job.img.reset();
+                    std::lock_guard<std::mutex> lk { cout_mutex };
+                    std::cout << "saved: " << output_file << std::endl;
+                }
+                catch (std::exception& e) {
+                    report_error(e);
+                }
+            }
+        });
     }
 
-    workers.clear(); // noexcept
+    // Color replacement on this thread, one image at a time with the whole pool behind it
+    for (Job job; decoded.pop(job);) {
+        try {
+            if (lattice) {
+                applyLUT(*job.img, *lattice, &pool);
+            } else {
+                applyLUT(*job.img, lut, strength, &pool);
+            }
+            applied.push(std::move(job));
+        }
+        catch (std::exception& e) {
+            report_error(e);
+        }
+    }
+    applied.close();
 
-    delete[] lut;
+    for (std::thread& t : stage_threads) {
+        t.join();
+    }
 
     return 0;
 }
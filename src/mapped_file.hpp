@@ -0,0 +1,127 @@
+// Created: 2026-10-16
+
+#ifndef _MAPPED_FILE_HPP_
+#define _MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lutools {
+
+/// \brief Read-only memory mapping of an entire file
+/// \details Pages are loaded on first touch and shared through the page cache with every other process mapping the same file
+class MappedFile {
+    const unsigned char* _data = nullptr;
+    std::size_t _size = 0;
+
+    void unmap() noexcept {
+        if (_data) {
+#ifdef _WIN32
+            UnmapViewOfFile(_data);
+#else
+            munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+
+public:
+#pragma region Move-only
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& src) noexcept:
+        _data(src._data),
+        _size(src._size) {
+        src._data = nullptr;
+        src._size = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& src) noexcept {
+        if (this != &src) {
+            unmap();
+            _data = src._data;
+            _size = src._size;
+            src._data = nullptr;
+            src._size = 0;
+        }
+        return *this;
+    }
+
+#pragma endregion
+
+    explicit MappedFile(const std::string& path) {
+        const std::string error_message = "unable to map file \"" + path + "\"";
+#ifdef _WIN32
+        const HANDLE file = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error { error_message };
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+            CloseHandle(file);
+            throw std::runtime_error { error_message };
+        }
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file); // The mapping keeps its own reference
+        if (!mapping) {
+            throw std::runtime_error { error_message };
+        }
+        _data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        CloseHandle(mapping); // So does the view
+        if (!_data) {
+            throw std::runtime_error { error_message };
+        }
+        _size = static_cast<std::size_t>(size.QuadPart);
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error { error_message };
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            throw std::runtime_error { error_message };
+        }
+        void* p = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // The mapping keeps its own reference
+        if (p == MAP_FAILED) {
+            throw std::runtime_error { error_message };
+        }
+        _data = static_cast<const unsigned char*>(p);
+        _size = static_cast<std::size_t>(info.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+        unmap();
+    }
+
+    /// \brief Returns the first byte of the file
+    const unsigned char* data() const noexcept { return _data; }
+    /// \brief Returns the size of the file in bytes
+    std::size_t size() const noexcept { return _size; }
+};
+}
+
+#endif // _MAPPED_FILE_HPP_
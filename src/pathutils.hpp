@@ -4,8 +4,10 @@
 #define _PATHUTILS_HPP_
 
 #include <cctype>
+#include <filesystem>
 #include <fstream>
 #include <string>
+#include <system_error>
 #include <algorithm>
 
 namespace Pathutils {
@@ -44,7 +46,7 @@ inline std::string getExtensionName(const std::string& path, bool to_lower = tru
     const auto where_dot = path.find_last_of('.');
     std::string result = where_dot != std::string::npos ? path.substr(where_dot + 1) : "";
     if (!result.empty() && to_lower) {
-        std::transform(result.begin(), result.end(), result.begin(), std::tolower);
+        std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
     }
     return result;
 }
@@ -60,6 +62,12 @@ inline std::string getSecondaryExtensionName(const std::string& path, bool to_lo
 inline bool isFileAvailable(const std::string& path) {
     return std::ifstream { path }.good();
 }
+
+/// \brief Checks if two paths lead to the same existing file, through links or not
+inline bool isSameFile(const std::string& path1, const std::string& path2) {
+    std::error_code ec;
+    return std::filesystem::equivalent(path1, path2, ec);
+}
 }
 
 #endif // _PATHUTILS_HPP_
@@ -0,0 +1,210 @@
+// Created: 2026-10-16
+
+#ifndef _PIPE_HPP_
+#define _PIPE_HPP_
+
+#include "apply.hpp"
+#include "color.hpp"
+#include "thread_pool.hpp"
+
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace Lutools {
+
+/// \brief Layout of the raw video frames going through a pipe, as ffmpeg's \c -f \c rawvideo
+struct FrameFormat {
+    int width = 0;
+    int height = 0;
+    bool alpha = false; ///< \c rgba if set, otherwise \c rgb24
+
+    /// \brief Returns the number of pixels in a frame
+    std::size_t getPixels() const noexcept { return static_cast<std::size_t>(width) * static_cast<std::size_t>(height); }
+    /// \brief Returns the size of a frame in bytes
+    std::size_t getBytes() const noexcept { return getPixels() * (alpha ? sizeof(Color) : sizeof(ColorRGB)); }
+};
+
+/// \brief Most pixels a frame may have, 16384 x 16384
+inline static constexpr std::uint64_t FRAME_MAX_PIXELS = static_cast<std::uint64_t>(1) << 28;
+
+/// \brief Parses a frame format like \c 3840x2160:rgb24 or \c 1920x1080:rgba
+/// \throw std::invalid_argument If the format is malformed, or the frame has more than \c FRAME_MAX_PIXELS pixels
+inline FrameFormat parseFrameFormat(const std::string& spec) {
+    FrameFormat format {};
+    const std::size_t x = spec.find('x');
+    const std::size_t colon = spec.find(':');
+    if (x == std::string::npos || colon == std::string::npos || colon < x) {
+        throw std::invalid_argument { "invalid frame format \"" + spec + "\", expecting WxH:rgb24 or WxH:rgba" };
+    }
+    // Each dimension must be digits only, spanning the whole field
+    const auto parse_side = [&](std::size_t begin, std::size_t end, int& side) {
+        const auto [ptr, ec] = std::from_chars(spec.data() + begin, spec.data() + end, side);
+        return ec == std::errc {} && ptr == spec.data() + end && spec[begin] != '-';
+    };
+    const bool sides_valid = parse_side(0, x, format.width) && parse_side(x + 1, colon, format.height);
+    const std::string pix_fmt = spec.substr(colon + 1);
+    if (!sides_valid || format.width <= 0 || format.height <= 0 || (pix_fmt != "rgb24" && pix_fmt != "rgba")) {
+        throw std::invalid_argument { "invalid frame format \"" + spec + "\", expecting WxH:rgb24 or WxH:rgba" };
+    }
+    if (static_cast<std::uint64_t>(format.width) * static_cast<std::uint64_t>(format.height) > FRAME_MAX_PIXELS) {
+        throw std::invalid_argument { "frame format \"" + spec + "\" is too large" };
+    }
+    format.alpha = pix_fmt == "rgba";
+    return format;
+}
+
+/// \brief Switches \c stdin and \c stdout to binary mode, where that is a thing
+inline void setBinaryStdio() noexcept {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+/// \brief State shared between \c pipeFrames and its reader thread, which may outlive the call
+struct PipeFrameBuffers {
+    // Color is 4-aligned, and so is every frame of either layout since that's how the buffer is allocated
+    std::vector<Color> storage[2];
+    std::size_t filled_bytes[2] {};
+
+    // Buffer i is full when ready[i] is set; the reader fills them in turn, so does the consumer drain them
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool ready[2] {};
+    bool input_ended = false;
+    bool stopping = false;
+    std::exception_ptr reader_error {};
+
+    explicit PipeFrameBuffers(std::size_t frame_bytes):
+        storage {
+            std::vector<Color>((frame_bytes + sizeof(Color) - 1) / sizeof(Color)),
+            std::vector<Color>((frame_bytes + sizeof(Color) - 1) / sizeof(Color))
+        } {}
+};
+
+/// \brief Applies a LUT to raw video frames read from one stream and written to another, until the input ends
+/// \details Two frame buffers are allocated up front and take turns: a reader thread fills one while the other is
+/// remapped across the pool and written, so reading overlaps with the work and no memory is allocated per frame.
+/// If writing fails, the reader may be blocked on an input that never ends; it is left behind rather than waited
+/// for, so \c in must stay open for as long as the process runs.
+/// \param lut Anything \c applyLUT accepts for a range of pixels: a LUT cache, a \c LutView or a \c LatticeLut
+/// \param pool The pool to spread each frame across; runs on the calling thread if \c nullptr
+/// \return Number of frames processed
+/// \throw std::runtime_error If the input ends in the middle of a frame, or writing fails
+template <typename LutTy>
+std::size_t pipeFrames(std::FILE* in, std::FILE* out, const FrameFormat& format, const LutTy& lut, ThreadPool* pool = nullptr) {
+    const std::size_t frame_bytes = format.getBytes();
+    const auto shared = std::make_shared<PipeFrameBuffers>(frame_bytes);
+    PipeFrameBuffers& buffers = *shared;
+
+    std::thread reader { [shared, in, frame_bytes] {
+        PipeFrameBuffers& buffers = *shared;
+        try {
+            for (std::size_t i = 0;; i ^= 1) {
+                {
+                    std::unique_lock<std::mutex> lk { buffers.mutex };
+                    buffers.changed.wait(lk, [&] { return !buffers.ready[i] || buffers.stopping; });
+                    if (buffers.stopping) { return; }
+                }
+                unsigned char* buffer = reinterpret_cast<unsigned char*>(buffers.storage[i].data());
+                std::size_t n = 0;
+                while (n < frame_bytes) {
+                    const std::size_t got = std::fread(buffer + n, 1, frame_bytes - n, in);
+                    if (!got) { break; }
+                    n += got;
+                }
+                std::lock_guard<std::mutex> lk { buffers.mutex };
+                if (!n) {
+                    buffers.input_ended = true;
+                } else {
+                    buffers.filled_bytes[i] = n;
+                    buffers.ready[i] = true;
+                    buffers.input_ended = n < frame_bytes;
+                }
+                buffers.changed.notify_all();
+                if (buffers.input_ended) { return; }
+            }
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lk { buffers.mutex };
+            buffers.reader_error = std::current_exception();
+            buffers.input_ended = true;
+            buffers.changed.notify_all();
+        }
+    } };
+
+    const auto stop_reader = [&] {
+        {
+            std::lock_guard<std::mutex> lk { buffers.mutex };
+            buffers.stopping = true;
+        }
+        buffers.changed.notify_all();
+    };
+
+    std::size_t frames = 0;
+    try {
+        for (std::size_t i = 0;; i ^= 1) {
+            {
+                std::unique_lock<std::mutex> lk { buffers.mutex };
+                buffers.changed.wait(lk, [&] { return buffers.ready[i] || buffers.input_ended; });
+                if (!buffers.ready[i]) { break; }
+            }
+            if (buffers.filled_bytes[i] != frame_bytes) {
+                throw std::runtime_error { "input ended in the middle of a frame" };
+            }
+
+            if (format.alpha) {
+                Color* pixels = buffers.storage[i].data();
+                applyLUT(pixels, pixels + format.getPixels(), lut, pool);
+            } else {
+                ColorRGB* pixels = reinterpret_cast<ColorRGB*>(buffers.storage[i].data());
+                applyLUT(pixels, pixels + format.getPixels(), lut, pool);
+            }
+            if (std::fwrite(buffers.storage[i].data(), 1, frame_bytes, out) != frame_bytes) {
+                throw std::runtime_error { "failed to write frame" };
+            }
+            ++frames;
+
+            {
+                std::lock_guard<std::mutex> lk { buffers.mutex };
+                buffers.ready[i] = false;
+            }
+            buffers.changed.notify_all();
+        }
+        if (std::fflush(out) != 0) {
+            throw std::runtime_error { "failed to write frame" };
+        }
+    }
+    catch (...) {
+        // The reader may be stuck in fread until more input comes, which may be never; it quits by itself once it
+        // gets out, and keeps the buffers alive until then
+        stop_reader();
+        reader.detach();
+        throw;
+    }
+    // The input has ended, so the reader is done or about to be
+    stop_reader();
+    reader.join();
+    if (buffers.reader_error) {
+        std::rethrow_exception(buffers.reader_error);
+    }
+    return frames;
+}
+}
+
+#endif // _PIPE_HPP_
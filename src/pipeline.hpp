@@ -0,0 +1,76 @@
+// Created: 2026-10-16
+
+#ifndef _PIPELINE_HPP_
+#define _PIPELINE_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace Lutools {
+
+/// \brief Multi-producer multi-consumer FIFO holding at most a fixed number of items, connecting the stages of a pipeline
+/// \details Producers block while the queue is full, which throttles a fast stage down to the pace of the next one
+/// and caps how many items are in flight between them.
+template <typename T>
+class BoundedQueue {
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+    std::deque<T> _items;
+    std::size_t _capacity;
+    bool _closed = false;
+
+public:
+    BoundedQueue(const BoundedQueue&) = delete;
+
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /// \param capacity Maximum number of queued items, at least 1
+    explicit BoundedQueue(std::size_t capacity):
+        _capacity(capacity ? capacity : 1) {}
+
+    /// \brief Appends an item, blocking while the queue is full
+    /// \return \c false if the queue has been closed, in which case the item is dropped
+    bool push(T item) {
+        std::unique_lock<std::mutex> lk { _mutex };
+        _not_full.wait(lk, [this] { return _closed || _items.size() < _capacity; });
+        if (_closed) {
+            return false;
+        }
+        _items.push_back(std::move(item));
+        lk.unlock();
+        _not_empty.notify_one();
+        return true;
+    }
+
+    /// \brief Takes the oldest item, blocking while the queue is empty
+    /// \return \c false once the queue has been closed and drained
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lk { _mutex };
+        _not_empty.wait(lk, [this] { return _closed || !_items.empty(); });
+        if (_items.empty()) {
+            return false;
+        }
+        item = std::move(_items.front());
+        _items.pop_front();
+        lk.unlock();
+        _not_full.notify_one();
+        return true;
+    }
+
+    /// \brief Marks the end of input; consumers drain what is left, further pushes fail
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk { _mutex };
+            _closed = true;
+        }
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+};
+}
+
+#endif // _PIPELINE_HPP_
@@ -0,0 +1,645 @@
+// Created: 2026-10-16
+
+#ifndef _PNG_HPP_
+#define _PNG_HPP_
+
+#include "color.hpp"
+#include "cpu.hpp"
+#include "deflate.hpp"
+#include "inflate.hpp"
+#include "row_io.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Trade-off between PNG file size and encoding speed
+enum class PngEffort : unsigned char {
+    Fast, ///< Filters None / Sub, single-probe deflate
+    Default, ///< All 5 filters tried per row, hash-chain deflate
+};
+
+/// \brief Target size of the filtered data in a band of rows, the unit of parallel PNG encoding
+inline static constexpr std::size_t PNG_BAND_BYTES = static_cast<std::size_t>(1) << 20;
+
+#pragma region Filtering
+
+/// \brief Sums the absolute values of a filtered row, its bytes taken as signed, the score PNG encoders pick filters by
+LUTOOLS_KERNEL_BODY std::size_t scorePngRow(const unsigned char* filtered, std::size_t row_bytes) noexcept {
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < row_bytes; ++i) {
+        sum += filtered[i] < 128 ? filtered[i] : 256 - filtered[i];
+    }
+    return sum;
+}
+
+/// \brief Filters a row of RGBA pixels, picking the filter with the least sum of absolute values
+/// \details Body of the versions of \c filterPngRow. The first pixel, which has nothing on its left, and the first row,
+/// which has nothing above, are handled apart so that the main loops run branch-free and vectorize.
+LUTOOLS_KERNEL_BODY void filterPngRowBody(
+    const unsigned char* row,
+    const unsigned char* prior,
+    std::size_t row_bytes,
+    PngEffort effort,
+    unsigned char* out,
+    unsigned char* scratch) noexcept {
+    constexpr std::size_t BPP = 4;
+    const std::size_t head = std::min(BPP, row_bytes);
+
+    unsigned char* candidates[5] { out + 1, scratch, scratch + row_bytes, scratch + 2 * row_bytes, scratch + 3 * row_bytes };
+
+    // 0: None
+    std::copy(row, row + row_bytes, candidates[0]);
+    // 1: Sub
+    std::copy(row, row + head, candidates[1]);
+    for (std::size_t i = BPP; i < row_bytes; ++i) {
+        candidates[1][i] = static_cast<unsigned char>(row[i] - row[i - BPP]);
+    }
+    int filter_count = 2;
+
+    if (effort == PngEffort::Default) {
+        // 2: Up, 3: Average, 4: Paeth
+        unsigned char* const up = candidates[2];
+        unsigned char* const average = candidates[3];
+        unsigned char* const paeth = candidates[4];
+        if (prior) {
+            // Nothing on the left, Paeth predicts from above
+            for (std::size_t i = 0; i < head; ++i) {
+                up[i] = static_cast<unsigned char>(row[i] - prior[i]);
+                average[i] = static_cast<unsigned char>(row[i] - (prior[i] >> 1));
+                paeth[i] = up[i];
+            }
+            for (std::size_t i = BPP; i < row_bytes; ++i) {
+                const int left = row[i - BPP];
+                const int above = prior[i];
+                const int corner = prior[i - BPP];
+                up[i] = static_cast<unsigned char>(row[i] - above);
+                average[i] = static_cast<unsigned char>(row[i] - ((left + above) >> 1));
+                const int p = left + above - corner;
+                const int pa = std::abs(p - left);
+                const int pb = std::abs(p - above);
+                const int pc = std::abs(p - corner);
+                const int predictor = pa <= pb && pa <= pc ? left : pb <= pc ? above : corner;
+                paeth[i] = static_cast<unsigned char>(row[i] - predictor);
+            }
+        } else {
+            // Nothing above, Up is None and Paeth is Sub
+            std::copy(row, row + row_bytes, up);
+            std::copy(row, row + head, average);
+            for (std::size_t i = BPP; i < row_bytes; ++i) {
+                average[i] = static_cast<unsigned char>(row[i] - (row[i - BPP] >> 1));
+            }
+            std::copy(candidates[1], candidates[1] + row_bytes, paeth);
+        }
+        filter_count = 5;
+    }
+
+    int best = 0;
+    std::size_t best_score = scorePngRow(candidates[0], row_bytes);
+    for (int f = 1; f < filter_count; ++f) {
+        const std::size_t s = scorePngRow(candidates[f], row_bytes);
+        if (s < best_score) {
+            best = f;
+            best_score = s;
+        }
+    }
+    out[0] = static_cast<unsigned char>(best);
+    if (best) {
+        std::copy(candidates[best], candidates[best] + row_bytes, out + 1);
+    }
+}
+
+/// \brief Baseline version of \c filterPngRow
+inline void filterPngRowBaseline(const unsigned char* row, const unsigned char* prior, std::size_t row_bytes, PngEffort effort, unsigned char* out, unsigned char* scratch) noexcept {
+    filterPngRowBody(row, prior, row_bytes, effort, out, scratch);
+}
+
+/// \brief AVX2 version of \c filterPngRow
+LUTOOLS_TARGET_AVX2 inline void filterPngRowAvx2(const unsigned char* row, const unsigned char* prior, std::size_t row_bytes, PngEffort effort, unsigned char* out, unsigned char* scratch) noexcept {
+    filterPngRowBody(row, prior, row_bytes, effort, out, scratch);
+}
+
+/// \brief AVX-512 version of \c filterPngRow
+LUTOOLS_TARGET_AVX512 inline void filterPngRowAvx512(const unsigned char* row, const unsigned char* prior, std::size_t row_bytes, PngEffort effort, unsigned char* out, unsigned char* scratch) noexcept {
+    filterPngRowBody(row, prior, row_bytes, effort, out, scratch);
+}
+
+/// \brief Filters a row of RGBA pixels, picking the filter with the least sum of absolute values
+/// \param row The raw row
+/// \param prior The raw row above, \c nullptr for the first row
+/// \param row_bytes Length of \c row
+/// \param out Filter type byte followed by the filtered row, \c row_bytes + 1 in total
+/// \param scratch At least 4 x \c row_bytes bytes for candidate rows
+/// \remark The version is chosen on first call, see \c selectKernel
+inline void filterPngRow(
+    const unsigned char* row,
+    const unsigned char* prior,
+    std::size_t row_bytes,
+    PngEffort effort,
+    unsigned char* out,
+    unsigned char* scratch) noexcept {
+    using FilterKernel = void (*)(const unsigned char*, const unsigned char*, std::size_t, PngEffort, unsigned char*, unsigned char*) noexcept;
+    static const FilterKernel kernel = selectKernel<FilterKernel>(filterPngRowBaseline, filterPngRowAvx2, filterPngRowAvx512);
+    kernel(row, prior, row_bytes, effort, out, scratch);
+}
+
+#pragma endregion
+
+/// \brief Writes a PNG chunk
+inline void writePngChunk(std::ostream& os, const char* type, const unsigned char* data, std::size_t size) {
+    const auto put32 = [&](std::uint32_t v) {
+        const char bytes[] {
+            static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v)
+        };
+        os.write(bytes, 4);
+    };
+    put32(static_cast<std::uint32_t>(size));
+    os.write(type, 4);
+    os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    put32(crc32(data, size, crc32(reinterpret_cast<const unsigned char*>(type), 4)));
+}
+
+/// \brief Streaming 8-bit RGBA PNG encoder
+/// \details Rows are cut into bands of about \c PNG_BAND_BYTES, each filtered and deflated on its own with the last
+/// 32 KiB of the data before it as the dictionary, and ending with a sync flush; every band becomes an IDAT chunk,
+/// so the bands can be encoded in parallel and written in order. Only the rows needed for the dictionary are kept
+/// between calls to \c writeRows.
+class PngWriter : public RowWriter {
+    std::unique_ptr<std::ostream> _owned_stream;
+    std::ostream* _os;
+    std::string _path;
+
+    int _w;
+    int _h;
+    PngEffort _effort;
+    std::size_t _row_bytes;
+    std::size_t _filtered_row_bytes;
+    std::size_t _band_rows;
+    std::size_t _dictionary_rows;
+
+    std::size_t _next_row = 0;
+    std::vector<unsigned char> _history; // The last rows written, raw; enough to rebuild the dictionary
+    std::size_t _history_rows = 0;
+    std::uint32_t _adler = 1;
+
+    void check() const {
+        if (!*_os) {
+            throw std::runtime_error { "failed to write to image file \"" + _path + "\"" };
+        }
+    }
+
+    void writeHeader() {
+        static const unsigned char signature[] { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        _os->write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+        const unsigned char ihdr[] {
+            static_cast<unsigned char>(_w >> 24), static_cast<unsigned char>(_w >> 16), static_cast<unsigned char>(_w >> 8), static_cast<unsigned char>(_w),
+            static_cast<unsigned char>(_h >> 24), static_cast<unsigned char>(_h >> 16), static_cast<unsigned char>(_h >> 8), static_cast<unsigned char>(_h),
+            8, // Bit depth
+            6, // RGBA
+            0, 0, 0 // Deflate, adaptive filtering, no interlace
+        };
+        writePngChunk(*_os, "IHDR", ihdr, sizeof(ihdr));
+        check();
+    }
+
+public:
+    /// \param os Binary output stream, which must outlive the writer
+    PngWriter(std::ostream& os, int w, int h, PngEffort effort = PngEffort::Default):
+        _os(&os),
+        _w(w),
+        _h(h),
+        _effort(effort),
+        _row_bytes(static_cast<std::size_t>(w) * 4),
+        _filtered_row_bytes(_row_bytes + 1),
+        _band_rows(std::max<std::size_t>(1, PNG_BAND_BYTES / _filtered_row_bytes)),
+        _dictionary_rows((32768 + _filtered_row_bytes - 1) / _filtered_row_bytes) {
+        if (w <= 0 || h <= 0) {
+            throw std::invalid_argument { "image to encode is empty" };
+        }
+        writeHeader();
+    }
+
+    /// \param path Path of the image file created / \b overwritten
+    PngWriter(const std::string& path, int w, int h, PngEffort effort = PngEffort::Default):
+        _owned_stream(std::make_unique<std::ofstream>(path, std::ios::binary)),
+        _os(_owned_stream.get()),
+        _path(path),
+        _w(w),
+        _h(h),
+        _effort(effort),
+        _row_bytes(static_cast<std::size_t>(w) * 4),
+        _filtered_row_bytes(_row_bytes + 1),
+        _band_rows(std::max<std::size_t>(1, PNG_BAND_BYTES / _filtered_row_bytes)),
+        _dictionary_rows((32768 + _filtered_row_bytes - 1) / _filtered_row_bytes) {
+        if (w <= 0 || h <= 0) {
+            throw std::invalid_argument { "image to encode is empty" };
+        }
+        check();
+        writeHeader();
+    }
+
+    void writeRows(const Color* rows, std::size_t count, ThreadPool* pool = nullptr) override {
+        const std::size_t height = static_cast<std::size_t>(_h);
+        if (count > height - _next_row) {
+            throw std::out_of_range { "too many rows written to PNG" };
+        }
+        if (!count) {
+            return;
+        }
+
+        const unsigned char* raw = reinterpret_cast<const unsigned char*>(rows);
+        const std::size_t first_row = _next_row;
+        const std::size_t history_first_row = first_row - _history_rows;
+        const auto get_row = [&](std::size_t y) {
+            return y >= first_row
+                ? raw + (y - first_row) * _row_bytes
+                : _history.data() + (y - history_first_row) * _row_bytes;
+        };
+
+        const std::size_t band_count = (count + _band_rows - 1) / _band_rows;
+        std::vector<std::vector<unsigned char>> idats(band_count);
+        std::vector<std::uint32_t> adlers(band_count);
+        std::vector<std::size_t> filtered_sizes(band_count);
+
+        parallelFor(pool, 0, band_count, 1, [&](std::size_t first, std::size_t last) {
+            std::vector<unsigned char> filtered;
+            std::vector<unsigned char> scratch(4 * _row_bytes);
+            DeflateEncoder encoder { _effort == PngEffort::Fast ? DeflateEffort::Fast : DeflateEffort::Default };
+
+            for (std::size_t band = first; band < last; ++band) {
+                // Filters are picked from the raw rows only, so refiltering the rows before the band reproduces
+                // exactly what the previous band compressed, i.e. the dictionary
+                const std::size_t begin_row = first_row + band * _band_rows;
+                const std::size_t end_row = std::min(first_row + count, begin_row + _band_rows);
+                const std::size_t dictionary_row = begin_row > _dictionary_rows ? begin_row - _dictionary_rows : 0;
+                filtered.resize((end_row - dictionary_row) * _filtered_row_bytes);
+                for (std::size_t y = dictionary_row; y < end_row; ++y) {
+                    filterPngRow(
+                        get_row(y),
+                        y ? get_row(y - 1) : nullptr,
+                        _row_bytes,
+                        _effort,
+                        filtered.data() + (y - dictionary_row) * _filtered_row_bytes,
+                        scratch.data());
+                }
+
+                const std::size_t start = (begin_row - dictionary_row) * _filtered_row_bytes;
+                adlers[band] = adler32(filtered.data() + start, filtered.size() - start);
+                filtered_sizes[band] = filtered.size() - start;
+
+                std::vector<unsigned char>& idat = idats[band];
+                idat.reserve((filtered.size() - start) / 2);
+                if (begin_row == 0) {
+                    // zlib header: deflate with a 32 KiB window, no preset dictionary, level hint
+                    idat.push_back(0x78);
+                    idat.push_back(_effort == PngEffort::Fast ? 0x01 : 0x9c);
+                }
+                encoder.compress(filtered.data(), start, filtered.size(), end_row == height, idat);
+            }
+        });
+
+        for (std::size_t band = 0; band < band_count; ++band) {
+            _adler = adler32Combine(_adler, adlers[band], filtered_sizes[band]);
+            writePngChunk(*_os, "IDAT", idats[band].data(), idats[band].size());
+            std::vector<unsigned char> {}.swap(idats[band]);
+        }
+        check();
+
+        // Keep the rows the next band will need: its dictionary, plus the row above that for filtering
+        const std::size_t keep = std::min(first_row + count, _dictionary_rows + 1);
+        std::vector<unsigned char> history(keep * _row_bytes);
+        for (std::size_t i = 0; i < keep; ++i) {
+            const unsigned char* row = get_row(first_row + count - keep + i);
+            std::copy(row, row + _row_bytes, history.data() + i * _row_bytes);
+        }
+        _history.swap(history);
+        _history_rows = keep;
+        _next_row += count;
+    }
+
+    void finish() override {
+        if (_next_row != static_cast<std::size_t>(_h)) {
+            throw std::logic_error { "PNG finished before all rows were written" };
+        }
+
+        // The zlib trailer gets an IDAT of its own, after all bands are checksummed
+        const unsigned char trailer[] {
+            static_cast<unsigned char>(_adler >> 24), static_cast<unsigned char>(_adler >> 16),
+            static_cast<unsigned char>(_adler >> 8), static_cast<unsigned char>(_adler)
+        };
+        writePngChunk(*_os, "IDAT", trailer, sizeof(trailer));
+        writePngChunk(*_os, "IEND", nullptr, 0);
+        _os->flush();
+        check();
+    }
+};
+
+/// \brief Encodes RGBA pixels as an 8-bit RGBA PNG
+/// \param os Binary output stream
+/// \param pixels \c w x \c h pixels, row by row
+/// \param pool The pool to spread the bands across; runs on the calling thread if \c nullptr
+inline void writePng(std::ostream& os, const Color* pixels, int w, int h, PngEffort effort = PngEffort::Default, ThreadPool* pool = nullptr) {
+    PngWriter writer { os, w, h, effort };
+    writer.writeRows(pixels, static_cast<std::size_t>(h), pool);
+    writer.finish();
+}
+
+/// \brief Encodes RGBA pixels as an 8-bit RGBA PNG file
+/// \param path Path of the image file created / \b overwritten
+/// \param pixels \c w x \c h pixels, row by row
+/// \param pool The pool to spread the bands across; runs on the calling thread if \c nullptr
+inline void writePng(const std::string& path, const Color* pixels, int w, int h, PngEffort effort = PngEffort::Default, ThreadPool* pool = nullptr) {
+    PngWriter writer { path, w, h, effort };
+    writer.writeRows(pixels, static_cast<std::size_t>(h), pool);
+    writer.finish();
+}
+
+/// \brief Streaming PNG decoder
+/// \details Handles every non-interlaced PNG: all bit depths and color types, including palettes and transparency
+/// (16-bit samples are cut to 8 bits). Only one row and the one above it are held besides the inflater state.
+class PngReader : public RowReader {
+    std::ifstream _ifs;
+    std::string _path;
+
+    int _w = 0;
+    int _h = 0;
+    int _depth = 0;
+    int _color_type = 0;
+    std::size_t _channels = 0;
+    std::size_t _bpp = 0; // Bytes per complete pixel, at least 1, the distance filters look back
+    std::size_t _row_bytes = 0;
+
+    std::array<Color, 256> _palette {};
+    bool _has_key = false;
+    std::array<std::uint16_t, 3> _key {}; // Transparent gray / RGB, in file samples
+
+    std::uint32_t _chunk_left = 0;
+    std::uint32_t _chunk_crc = 0;
+    bool _idat_done = false;
+    std::unique_ptr<Inflater> _inflater;
+
+    std::vector<unsigned char> _row;
+    std::vector<unsigned char> _prior;
+    std::size_t _next_row = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error { "failed to load image file \"" + _path + "\": " + what };
+    }
+
+    std::uint32_t readU32() {
+        unsigned char b[4];
+        if (!_ifs.read(reinterpret_cast<char*>(b), 4)) {
+            fail("unexpected end of file");
+        }
+        return static_cast<std::uint32_t>(b[0]) << 24 | b[1] << 16 | b[2] << 8 | b[3];
+    }
+
+    /// \brief Reads a whole chunk, checking its CRC
+    std::vector<unsigned char> readChunkData(std::uint32_t length, const char* type) {
+        std::vector<unsigned char> data(length);
+        if (length && !_ifs.read(reinterpret_cast<char*>(data.data()), length)) {
+            fail("unexpected end of file");
+        }
+        if (readU32() != crc32(data.data(), length, crc32(reinterpret_cast<const unsigned char*>(type), 4))) {
+            fail(std::string { "CRC mismatch in chunk " } + type);
+        }
+        return data;
+    }
+
+    /// \brief Feeds the inflater with the contents of consecutive IDAT chunks
+    std::size_t readIdat(unsigned char* buffer, std::size_t size) {
+        while (!_chunk_left) {
+            if (_idat_done) {
+                return 0;
+            }
+            if (readU32() != _chunk_crc) {
+                fail("CRC mismatch in chunk IDAT");
+            }
+            const std::uint32_t length = readU32();
+            char type[4];
+            if (!_ifs.read(type, 4)) {
+                fail("unexpected end of file");
+            }
+            if (std::memcmp(type, "IDAT", 4) != 0) {
+                // Whatever follows the image data is of no interest
+                _idat_done = true;
+                return 0;
+            }
+            _chunk_left = length;
+            _chunk_crc = crc32(reinterpret_cast<const unsigned char*>(type), 4);
+        }
+
+        const std::size_t n = std::min<std::size_t>(size, _chunk_left);
+        if (!_ifs.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(n))) {
+            fail("unexpected end of file");
+        }
+        _chunk_crc = crc32(buffer, n, _chunk_crc);
+        _chunk_left -= static_cast<std::uint32_t>(n);
+        return n;
+    }
+
+    void unfilterRow() {
+        const int filter = _row[0];
+        unsigned char* cur = _row.data() + 1;
+        const unsigned char* up = _prior.data() + 1;
+        const std::size_t n = _row_bytes;
+        switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (std::size_t i = _bpp; i < n; ++i) { cur[i] = static_cast<unsigned char>(cur[i] + cur[i - _bpp]); }
+            break;
+        case 2:
+            for (std::size_t i = 0; i < n; ++i) { cur[i] = static_cast<unsigned char>(cur[i] + up[i]); }
+            break;
+        case 3:
+            for (std::size_t i = 0; i < n; ++i) {
+                const int left = i >= _bpp ? cur[i - _bpp] : 0;
+                cur[i] = static_cast<unsigned char>(cur[i] + ((left + up[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (std::size_t i = 0; i < n; ++i) {
+                const int left = i >= _bpp ? cur[i - _bpp] : 0;
+                const int above = up[i];
+                const int corner = i >= _bpp ? up[i - _bpp] : 0;
+                const int p = left + above - corner;
+                const int pa = std::abs(p - left);
+                const int pb = std::abs(p - above);
+                const int pc = std::abs(p - corner);
+                cur[i] = static_cast<unsigned char>(cur[i] + (pa <= pb && pa <= pc ? left : pb <= pc ? above : corner));
+            }
+            break;
+        default:
+            fail("invalid filter type");
+        }
+    }
+
+    /// \brief Returns sample \c i of the current row, at its original bit depth
+    unsigned getSample(std::size_t i) const noexcept {
+        const unsigned char* data = _row.data() + 1;
+        if (_depth == 16) {
+            return data[2 * i] << 8 | data[2 * i + 1];
+        }
+        if (_depth == 8) {
+            return data[i];
+        }
+        const std::size_t bit = i * _depth;
+        return (data[bit >> 3] >> (8 - _depth - (bit & 7))) & ((1u << _depth) - 1);
+    }
+
+    unsigned char to8Bits(unsigned sample) const noexcept {
+        if (_depth == 16) { return static_cast<unsigned char>(sample >> 8); }
+        return static_cast<unsigned char>(sample * 255 / ((1u << _depth) - 1));
+    }
+
+    void convertRow(Color* out) const noexcept {
+        for (std::size_t x = 0; x < static_cast<std::size_t>(_w); ++x) {
+            const std::size_t s = x * _channels;
+            switch (_color_type) {
+            case 0: {
+                const unsigned g = getSample(s);
+                const unsigned char v = to8Bits(g);
+                out[x] = { v, v, v, static_cast<unsigned char>(_has_key && g == _key[0] ? 0 : 255) };
+                break;
+            }
+            case 2: {
+                const unsigned r = getSample(s);
+                const unsigned g = getSample(s + 1);
+                const unsigned b = getSample(s + 2);
+                const bool transparent = _has_key && r == _key[0] && g == _key[1] && b == _key[2];
+                out[x] = { to8Bits(r), to8Bits(g), to8Bits(b), static_cast<unsigned char>(transparent ? 0 : 255) };
+                break;
+            }
+            case 3:
+                out[x] = _palette[getSample(s)];
+                break;
+            case 4: {
+                const unsigned char v = to8Bits(getSample(s));
+                out[x] = { v, v, v, to8Bits(getSample(s + 1)) };
+                break;
+            }
+            default:
+                out[x] = { to8Bits(getSample(s)), to8Bits(getSample(s + 1)), to8Bits(getSample(s + 2)), to8Bits(getSample(s + 3)) };
+                break;
+            }
+        }
+    }
+
+public:
+    /// \brief Opens a PNG file, reading everything up to the image data
+    explicit PngReader(const std::string& path):
+        _ifs(path, std::ios::binary),
+        _path(path) {
+        static const unsigned char signature[] { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        unsigned char head[8];
+        if (!_ifs.read(reinterpret_cast<char*>(head), 8) || std::memcmp(head, signature, 8) != 0) {
+            fail("not a PNG file");
+        }
+
+        for (bool header_seen = false;;) {
+            const std::uint32_t length = readU32();
+            char type[4];
+            if (!_ifs.read(type, 4)) {
+                fail("unexpected end of file");
+            }
+            const std::string name { type, 4 };
+            if (name == "IDAT") {
+                if (!header_seen) { fail("missing IHDR"); }
+                _chunk_left = length;
+                _chunk_crc = crc32(reinterpret_cast<const unsigned char*>(type), 4);
+                break;
+            }
+            if (name == "IEND") {
+                fail("missing image data");
+            }
+
+            const std::vector<unsigned char> data = readChunkData(length, type);
+            if (name == "IHDR") {
+                if (length != 13) { fail("invalid IHDR"); }
+                _w = static_cast<int>(data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3]);
+                _h = static_cast<int>(data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7]);
+                _depth = data[8];
+                _color_type = data[9];
+                if (_w <= 0 || _h <= 0) { fail("invalid dimensions"); }
+                if (data[12]) { fail("interlaced PNG can't be streamed"); }
+                switch (_color_type) {
+                case 0: _channels = 1; break;
+                case 2: _channels = 3; break;
+                case 3: _channels = 1; break;
+                case 4: _channels = 2; break;
+                case 6: _channels = 4; break;
+                default: fail("invalid color type");
+                }
+                const bool depth_ok = _depth == 8
+                    || (_depth == 16 && _color_type != 3)
+                    || ((_depth == 1 || _depth == 2 || _depth == 4) && (_color_type == 0 || _color_type == 3));
+                if (!depth_ok) { fail("invalid bit depth"); }
+                _bpp = std::max<std::size_t>(1, _channels * _depth / 8);
+                _row_bytes = (static_cast<std::size_t>(_w) * _channels * _depth + 7) / 8;
+                header_seen = true;
+            } else if (name == "PLTE") {
+                for (std::size_t i = 0; i < std::min<std::size_t>(256, length / 3); ++i) {
+                    _palette[i] = { data[3 * i], data[3 * i + 1], data[3 * i + 2], 255 };
+                }
+            } else if (name == "tRNS") {
+                if (_color_type == 3) {
+                    for (std::size_t i = 0; i < std::min<std::size_t>(256, length); ++i) {
+                        _palette[i].a = data[i];
+                    }
+                } else if (_color_type == 0 && length >= 2) {
+                    _has_key = true;
+                    _key[0] = static_cast<std::uint16_t>(data[0] << 8 | data[1]);
+                } else if (_color_type == 2 && length >= 6) {
+                    _has_key = true;
+                    for (std::size_t c = 0; c < 3; ++c) {
+                        _key[c] = static_cast<std::uint16_t>(data[2 * c] << 8 | data[2 * c + 1]);
+                    }
+                }
+            }
+        }
+
+        _inflater = std::make_unique<Inflater>([this](unsigned char* buffer, std::size_t size) { return readIdat(buffer, size); });
+        unsigned char zlib_header[2];
+        if (readIdat(zlib_header, 1) != 1 || readIdat(zlib_header + 1, 1) != 1
+            || (zlib_header[0] & 0x0f) != 8 || (zlib_header[0] << 8 | zlib_header[1]) % 31 || (zlib_header[1] & 0x20)) {
+            fail("invalid zlib header");
+        }
+
+        _row.resize(_row_bytes + 1);
+        _prior.assign(_row_bytes + 1, 0);
+    }
+
+    int getWidth() const noexcept override { return _w; }
+    int getHeight() const noexcept override { return _h; }
+
+    void readRows(Color* rows, std::size_t count) override {
+        if (count > static_cast<std::size_t>(_h) - _next_row) {
+            throw std::out_of_range { "too many rows read from PNG" };
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            if (_inflater->read(_row.data(), _row.size()) != _row.size()) {
+                fail("image data is truncated");
+            }
+            unfilterRow();
+            convertRow(rows + i * static_cast<std::size_t>(_w));
+            _row.swap(_prior);
+        }
+        _next_row += count;
+    }
+};
+}
+
+#endif // _PNG_HPP_
@@ -0,0 +1,203 @@
+// Created: 2026-10-16
+
+#ifndef _PNM_HPP_
+#define _PNM_HPP_
+
+#include "color.hpp"
+#include "row_io.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Streaming decoder of binary Netpbm images: PGM (P5), PPM (P6) and PAM (P7) with 1 to 4 channels
+/// \details Samples deeper than 8 bits are scaled down; a PAM with 2 or 4 channels carries alpha.
+class PnmReader : public RowReader {
+    std::ifstream _ifs;
+    std::string _path;
+
+    int _w = 0;
+    int _h = 0;
+    std::size_t _channels = 0;
+    unsigned _max_value = 0;
+    std::size_t _row_bytes = 0;
+    std::vector<unsigned char> _row;
+    std::size_t _next_row = 0;
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error { "failed to load image file \"" + _path + "\": " + what };
+    }
+
+    /// \brief Reads the next whitespace-separated token of a header, skipping comments
+    std::string readToken() {
+        std::string token;
+        for (int c; (c = _ifs.get()) != EOF;) {
+            if (c == '#') {
+                while ((c = _ifs.get()) != EOF && c != '\n') {}
+                if (token.empty()) { continue; }
+                break;
+            }
+            if (std::isspace(c)) {
+                if (token.empty()) { continue; }
+                break;
+            }
+            token.push_back(static_cast<char>(c));
+        }
+        return token;
+    }
+
+    unsigned readNumber() {
+        const std::string token = readToken();
+        try {
+            return static_cast<unsigned>(std::stoul(token));
+        }
+        catch (std::exception&) {
+            fail("invalid header field \"" + token + "\"");
+        }
+    }
+
+    unsigned char to8Bits(const unsigned char* sample) const noexcept {
+        if (_max_value == 255) {
+            return *sample;
+        }
+        const unsigned value = _max_value > 255 ? (sample[0] << 8 | sample[1]) : sample[0];
+        return static_cast<unsigned char>((std::min(value, _max_value) * 255 + _max_value / 2) / _max_value);
+    }
+
+public:
+    /// \brief Opens a Netpbm file, reading its header
+    explicit PnmReader(const std::string& path):
+        _ifs(path, std::ios::binary),
+        _path(path) {
+        const std::string magic = readToken();
+        if (magic == "P5" || magic == "P6") {
+            _w = static_cast<int>(readNumber());
+            _h = static_cast<int>(readNumber());
+            _max_value = readNumber();
+            _channels = magic == "P5" ? 1 : 3;
+        } else if (magic == "P7") {
+            for (std::string field; (field = readToken()) != "ENDHDR";) {
+                if (field.empty()) { fail("unterminated PAM header"); }
+                if (field == "WIDTH") { _w = static_cast<int>(readNumber()); }
+                else if (field == "HEIGHT") { _h = static_cast<int>(readNumber()); }
+                else if (field == "DEPTH") { _channels = readNumber(); }
+                else if (field == "MAXVAL") { _max_value = readNumber(); }
+                else if (field == "TUPLTYPE") { readToken(); }
+                else { fail("unknown PAM header field \"" + field + "\""); }
+            }
+        } else {
+            fail("not a binary PGM, PPM or PAM file");
+        }
+        if (_w <= 0 || _h <= 0) { fail("invalid dimensions"); }
+        if (_channels < 1 || _channels > 4) { fail("unsupported number of channels"); }
+        if (_max_value < 1 || _max_value > 65535) { fail("invalid maximum value"); }
+
+        _row_bytes = static_cast<std::size_t>(_w) * _channels * (_max_value > 255 ? 2 : 1);
+        _row.resize(_row_bytes);
+    }
+
+    int getWidth() const noexcept override { return _w; }
+    int getHeight() const noexcept override { return _h; }
+
+    void readRows(Color* rows, std::size_t count) override {
+        if (count > static_cast<std::size_t>(_h) - _next_row) {
+            throw std::out_of_range { "too many rows read from Netpbm image" };
+        }
+        const std::size_t sample_bytes = _max_value > 255 ? 2 : 1;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!_ifs.read(reinterpret_cast<char*>(_row.data()), static_cast<std::streamsize>(_row_bytes))) {
+                fail("image data is truncated");
+            }
+            Color* out = rows + i * static_cast<std::size_t>(_w);
+            const unsigned char* in = _row.data();
+            for (std::size_t x = 0; x < static_cast<std::size_t>(_w); ++x, in += _channels * sample_bytes) {
+                const auto sample = [&](std::size_t c) { return to8Bits(in + c * sample_bytes); };
+                switch (_channels) {
+                case 1: out[x] = { sample(0), sample(0), sample(0), 255 }; break;
+                case 2: out[x] = { sample(0), sample(0), sample(0), sample(1) }; break;
+                case 3: out[x] = { sample(0), sample(1), sample(2), 255 }; break;
+                default: out[x] = { sample(0), sample(1), sample(2), sample(3) }; break;
+                }
+            }
+        }
+        _next_row += count;
+    }
+};
+
+/// \brief Streaming encoder of binary PPM (P6, RGB) or PAM (P7, RGB_ALPHA) images
+class PnmWriter : public RowWriter {
+    std::ofstream _ofs;
+    std::string _path;
+    int _w;
+    int _h;
+    bool _alpha;
+    std::size_t _next_row = 0;
+    std::vector<unsigned char> _row;
+
+    void check() const {
+        if (!_ofs) {
+            throw std::runtime_error { "failed to write to image file \"" + _path + "\"" };
+        }
+    }
+
+public:
+    /// \param path Path of the image file created / \b overwritten
+    /// \param alpha Whether to write a PAM keeping alpha, otherwise a PPM
+    PnmWriter(const std::string& path, int w, int h, bool alpha):
+        _ofs(path, std::ios::binary),
+        _path(path),
+        _w(w),
+        _h(h),
+        _alpha(alpha),
+        _row(static_cast<std::size_t>(w) * (alpha ? 4 : 3)) {
+        if (w <= 0 || h <= 0) {
+            throw std::invalid_argument { "image to encode is empty" };
+        }
+        if (alpha) {
+            _ofs << "P7\nWIDTH " << w << "\nHEIGHT " << h << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+        } else {
+            _ofs << "P6\n" << w << " " << h << "\n255\n";
+        }
+        check();
+    }
+
+    void writeRows(const Color* rows, std::size_t count, ThreadPool* = nullptr) override {
+        if (count > static_cast<std::size_t>(_h) - _next_row) {
+            throw std::out_of_range { "too many rows written to Netpbm image" };
+        }
+        const std::size_t w = static_cast<std::size_t>(_w);
+        if (_alpha) {
+            _ofs.write(reinterpret_cast<const char*>(rows), static_cast<std::streamsize>(count * w * 4));
+        } else {
+            for (std::size_t y = 0; y < count; ++y) {
+                for (std::size_t x = 0; x < w; ++x) {
+                    const Color& px = rows[y * w + x];
+                    _row[3 * x] = px.r;
+                    _row[3 * x + 1] = px.g;
+                    _row[3 * x + 2] = px.b;
+                }
+                _ofs.write(reinterpret_cast<const char*>(_row.data()), static_cast<std::streamsize>(_row.size()));
+            }
+        }
+        check();
+        _next_row += count;
+    }
+
+    void finish() override {
+        if (_next_row != static_cast<std::size_t>(_h)) {
+            throw std::logic_error { "Netpbm image finished before all rows were written" };
+        }
+        _ofs.flush();
+        check();
+    }
+};
+}
+
+#endif // _PNM_HPP_
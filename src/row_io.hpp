@@ -0,0 +1,48 @@
+// Created: 2026-10-16
+
+#ifndef _ROW_IO_HPP_
+#define _ROW_IO_HPP_
+
+#include "color.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Lutools {
+
+/// \brief Image decoder handing out rows top to bottom, a band at a time, so the whole image never has to be in memory
+class RowReader {
+public:
+    virtual ~RowReader() = default;
+
+    /// \brief Returns the width of the image
+    virtual int getWidth() const noexcept = 0;
+    /// \brief Returns the height of the image
+    virtual int getHeight() const noexcept = 0;
+    /// \brief Returns the total number of pixels on the image
+    std::uint64_t getTotalPixels() const noexcept {
+        return static_cast<std::uint64_t>(getWidth()) * static_cast<std::uint64_t>(getHeight());
+    }
+
+    /// \brief Decodes the next rows as RGBA
+    /// \param rows Space for \c count x width pixels
+    virtual void readRows(Color* rows, std::size_t count) = 0;
+};
+
+/// \brief Image encoder taking rows top to bottom, a band at a time
+class RowWriter {
+public:
+    virtual ~RowWriter() = default;
+
+    /// \brief Encodes the next rows
+    /// \param rows \c count x width pixels
+    /// \param pool The pool to spread encoding across, if the format allows; runs on the calling thread if \c nullptr
+    virtual void writeRows(const Color* rows, std::size_t count, ThreadPool* pool = nullptr) = 0;
+
+    /// \brief Completes the file, once every row has been written
+    virtual void finish() = 0;
+};
+}
+
+#endif // _ROW_IO_HPP_
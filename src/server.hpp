@@ -0,0 +1,387 @@
+// Created: 2026-10-16
+
+#ifndef _SERVER_HPP_
+#define _SERVER_HPP_
+
+#include "apply.hpp"
+#include "image.hpp"
+#include "lut_cache.hpp"
+#include "pipe.hpp"
+#include "pipeline.hpp"
+#include "stream_apply.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Lutools {
+
+/// \brief Maximum number of requests of one connection being processed at a time
+inline static constexpr std::size_t SERVER_PIPELINE_DEPTH = 64;
+
+/// \brief Number of most recent requests latency percentiles are computed over
+inline static constexpr std::size_t SERVER_LATENCY_WINDOW = 4096;
+
+/// \brief Pause before accepting connections again after a failure that isn't transient
+inline static constexpr std::chrono::milliseconds SERVER_ACCEPT_BACKOFF { 100 };
+
+/// \brief Daemon applying LUTs on request, over a Unix domain socket
+/// \details Requests are lines of tab-separated fields, answered in order on the same connection:
+/// - <tt>APPLY lut input output</tt> applies a LUT to an image file, answering <tt>OK latency_us</tt>
+/// - <tt>APPLYBUF lut WxH:fmt size</tt> followed by \c size bytes of raw \c rgb24 or \c rgba pixels, answering
+///   <tt>OK latency_us size</tt> followed by the remapped pixels
+/// - \c STATS answers <tt>OK</tt> followed by \c key=value fields: request and error counts, latency percentiles
+///   and LUT cache figures
+/// - \c QUIT closes the connection
+///
+/// Failed requests are answered with <tt>ERR message</tt>. Clients may send any number of requests without waiting:
+/// up to \c SERVER_PIPELINE_DEPTH of them are processed concurrently across the pool. LUTs stay loaded in a
+/// \c LutCache, so only the first request for a filter pays for reading it. Relative paths are resolved against the
+/// working directory of the daemon.
+class LutServer {
+    std::string _socket_path;
+    ThreadPool& _pool;
+    PngEffort _png_effort;
+
+    LutCache _luts;
+
+    // Latencies of the most recent requests, in microseconds
+    std::mutex _stats_mutex;
+    std::vector<std::uint32_t> _latencies;
+    std::uint64_t _requests = 0;
+    std::uint64_t _errors = 0;
+
+    void record(std::chrono::steady_clock::duration latency, bool failed) {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        std::lock_guard<std::mutex> lk { _stats_mutex };
+        if (_latencies.size() < SERVER_LATENCY_WINDOW) {
+            _latencies.push_back(static_cast<std::uint32_t>(us));
+        } else {
+            _latencies[_requests % SERVER_LATENCY_WINDOW] = static_cast<std::uint32_t>(us);
+        }
+        ++_requests;
+        _errors += failed;
+    }
+
+    std::string getStats() {
+        std::vector<std::uint32_t> latencies;
+        std::uint64_t requests, errors;
+        {
+            std::lock_guard<std::mutex> lk { _stats_mutex };
+            latencies = _latencies;
+            requests = _requests;
+            errors = _errors;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&](unsigned p) -> std::uint32_t {
+            return latencies.empty() ? 0 : latencies[(latencies.size() - 1) * p / 100];
+        };
+
+        std::ostringstream oss;
+        oss << "OK\trequests=" << requests << "\terrors=" << errors
+            << "\tp50_us=" << percentile(50) << "\tp90_us=" << percentile(90) << "\tp99_us=" << percentile(99)
+            << "\tmax_us=" << (latencies.empty() ? 0 : latencies.back());
+        const LutCache::Stats lut_stats = _luts.getStats();
+        oss << "\tlut_hits=" << lut_stats.hits << "\tlut_misses=" << lut_stats.misses
+            << "\tluts_resident=" << lut_stats.resident_luts << "\tlut_bytes=" << lut_stats.resident_bytes << "\n";
+        return oss.str();
+    }
+
+    /// \brief Runs a request on the pool, the response of which is ready once the returned future is
+    template <typename FnTy>
+    std::future<std::string> dispatch(FnTy&& fn) {
+        auto task = std::make_shared<std::packaged_task<std::string()>>(
+            [this, fn = std::forward<FnTy>(fn), start = std::chrono::steady_clock::now()] {
+                try {
+                    std::string response = fn();
+                    const auto latency = std::chrono::steady_clock::now() - start;
+                    record(latency, false);
+                    // Responses lead with their latency
+                    const std::string us = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+                    return "OK\t" + us + response;
+                }
+                catch (std::exception& e) {
+                    record(std::chrono::steady_clock::now() - start, true);
+                    return std::string { "ERR\t" } + e.what() + "\n";
+                }
+            });
+        std::future<std::string> response = task->get_future();
+        _pool.submit([task] { (*task)(); });
+        return response;
+    }
+
+    static std::future<std::string> makeReady(std::string response) {
+        std::promise<std::string> promise;
+        promise.set_value(std::move(response));
+        return promise.get_future();
+    }
+
+    static std::vector<std::string> split(const std::string& line) {
+        std::vector<std::string> fields;
+        std::size_t begin = 0;
+        for (std::size_t tab; (tab = line.find('\t', begin)) != std::string::npos; begin = tab + 1) {
+            fields.push_back(line.substr(begin, tab - begin));
+        }
+        fields.push_back(line.substr(begin));
+        return fields;
+    }
+
+    /// \brief Parses a byte count made of decimal digits only, so that no sign or junk gets through
+    /// \throw std::invalid_argument If the size is malformed or out of range
+    static std::size_t parseSize(const std::string& field) {
+        std::size_t size = 0;
+        const char* end = field.data() + field.size();
+        const auto [ptr, ec] = std::from_chars(field.data(), end, size);
+        if (field.empty() || field[0] == '-' || ec != std::errc {} || ptr != end) {
+            throw std::invalid_argument { "invalid buffer size \"" + field + "\"" };
+        }
+        return size;
+    }
+
+#ifndef _WIN32
+    /// \brief Buffered reads from a socket
+    class SocketReader {
+        int _fd;
+        std::vector<char> _buffer;
+        std::size_t _pos = 0;
+        std::size_t _end = 0;
+
+        bool fill() {
+            _pos = 0;
+            const ssize_t n = ::recv(_fd, _buffer.data(), _buffer.size(), 0);
+            _end = n > 0 ? static_cast<std::size_t>(n) : 0;
+            return n > 0;
+        }
+
+    public:
+        explicit SocketReader(int fd):
+            _fd(fd),
+            _buffer(1 << 16) {}
+
+        bool readLine(std::string& line) {
+            line.clear();
+            for (;;) {
+                if (_pos == _end && !fill()) {
+                    return false;
+                }
+                const char* begin = _buffer.data() + _pos;
+                const char* newline = static_cast<const char*>(std::memchr(begin, '\n', _end - _pos));
+                if (newline) {
+                    line.append(begin, newline);
+                    _pos += static_cast<std::size_t>(newline - begin) + 1;
+                    if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+                    return true;
+                }
+                line.append(begin, _end - _pos);
+                _pos = _end;
+            }
+        }
+
+        bool readBytes(char* out, std::size_t size) {
+            while (size) {
+                if (_pos == _end && !fill()) {
+                    return false;
+                }
+                const std::size_t n = std::min(size, _end - _pos);
+                std::memcpy(out, _buffer.data() + _pos, n);
+                _pos += n;
+                out += n;
+                size -= n;
+            }
+            return true;
+        }
+    };
+
+    static bool sendAll(int fd, const char* data, std::size_t size) {
+        while (size) {
+            const ssize_t n = ::send(fd, data, size, 0);
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    void serveConnection(int fd) {
+        // Responses go out in request order, by a writer waiting on each in turn while later ones are in the works
+        BoundedQueue<std::future<std::string>> responses { SERVER_PIPELINE_DEPTH };
+        std::thread writer { [&] {
+            bool connected = true;
+            for (std::future<std::string> response; responses.pop(response);) {
+                const std::string data = response.get();
+                connected = connected && sendAll(fd, data.data(), data.size());
+            }
+        } };
+
+        // Whatever breaks the request loop, the writer is still running and must be wound down before leaving
+        try {
+            SocketReader reader { fd };
+            for (std::string line; reader.readLine(line);) {
+                const std::vector<std::string> fields = split(line);
+                const std::string& command = fields[0];
+                if (command.empty()) {
+                    continue;
+                }
+
+                if (command == "APPLY" && fields.size() == 4) {
+                    responses.push(dispatch([this, lut_file = fields[1], input_file = fields[2], output_file = fields[3]] {
+                        const LutView lut = _luts.get(lut_file);
+                        std::unique_ptr<RowReader> row_reader {};
+                        try {
+                            row_reader = openRowReader(input_file);
+                        }
+                        catch (std::exception&) {} // Let stb have a go
+                        std::unique_ptr<RowWriter> row_writer {};
+                        // Streaming onto the input itself would truncate it before it's read
+                        if (row_reader && row_reader->getTotalPixels() >= STREAM_MIN_PIXELS && !Pathutils::isSameFile(input_file, output_file)) {
+                            row_writer = openRowWriter(output_file, row_reader->getWidth(), row_reader->getHeight(), _png_effort);
+                        }
+                        if (row_writer) {
+                            applyLUT(*row_reader, *row_writer, lut, &_pool);
+                        } else {
+                            row_reader.reset();
+                            Image img { input_file };
+                            applyLUT(img, lut, &_pool);
+                            img.save(output_file, &_pool, _png_effort);
+                        }
+                        return std::string { "\n" };
+                    }));
+                } else if (command == "APPLYBUF" && fields.size() == 4) {
+                    std::size_t size = 0;
+                    FrameFormat format {};
+                    try {
+                        format = parseFrameFormat(fields[2]);
+                        size = parseSize(fields[3]);
+                        if (size != format.getBytes()) {
+                            throw std::invalid_argument { "buffer size doesn't match the frame format" };
+                        }
+                    }
+                    catch (std::exception& e) {
+                        // The payload can't be trusted to be what it claims, so the connection can't be resynchronized,
+                        // and nothing is allocated for it
+                        responses.push(makeReady(std::string { "ERR\t" } + e.what() + "\n"));
+                        break;
+                    }
+                    auto pixels = std::make_shared<std::vector<Color>>((size + sizeof(Color) - 1) / sizeof(Color));
+                    if (!reader.readBytes(reinterpret_cast<char*>(pixels->data()), size)) {
+                        break;
+                    }
+                    responses.push(dispatch([this, lut_file = fields[1], format, size, pixels] {
+                        const LutView lut = _luts.get(lut_file);
+                        if (format.alpha) {
+                            applyLUT(pixels->data(), pixels->data() + format.getPixels(), lut, &_pool);
+                        } else {
+                            ColorRGB* begin = reinterpret_cast<ColorRGB*>(pixels->data());
+                            applyLUT(begin, begin + format.getPixels(), lut, &_pool);
+                        }
+                        std::string response = "\t" + std::to_string(size) + "\n";
+                        response.append(reinterpret_cast<const char*>(pixels->data()), size);
+                        return response;
+                    }));
+                } else if (command == "STATS") {
+                    // Taken once the writer gets to it, so that it covers every request before it
+                    responses.push(std::async(std::launch::deferred, [this] { return getStats(); }));
+                } else if (command == "QUIT") {
+                    break;
+                } else {
+                    responses.push(makeReady("ERR\tunknown request \"" + command + "\"\n"));
+                }
+            }
+        }
+        catch (std::exception&) {
+        }
+
+        responses.close();
+        writer.join();
+        ::close(fd);
+    }
+#endif
+
+public:
+    /// \param socket_path Path of the socket to listen on, replaced if it exists
+    /// \param pool The pool requests are processed on
+    /// \param lut_budget Memory budget in bytes of the LUTs kept resident
+    /// \param png_effort Trade-off between PNG file size and encoding speed
+    LutServer(std::string socket_path, ThreadPool& pool, std::size_t lut_budget = LUT_CACHE_DEFAULT_BUDGET, PngEffort png_effort = PngEffort::Default):
+        _socket_path(std::move(socket_path)),
+        _pool(pool),
+        _png_effort(png_effort),
+        _luts(lut_budget, &pool) {
+        _latencies.reserve(SERVER_LATENCY_WINDOW);
+    }
+
+    /// \brief Listens and serves connections, each on a thread of its own; never returns unless listening fails
+    /// \throw std::runtime_error If the socket can't be set up
+    void run() {
+#ifdef _WIN32
+        throw std::runtime_error { "serving over a Unix domain socket isn't supported on this platform" };
+#else
+        // A client hanging up shouldn't take the daemon down
+        std::signal(SIGPIPE, SIG_IGN);
+
+        sockaddr_un address {};
+        if (_socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error { "socket path \"" + _socket_path + "\" is too long" };
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, _socket_path.c_str(), _socket_path.size() + 1);
+
+        const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0) {
+            throw std::runtime_error { "unable to create socket" };
+        }
+        ::unlink(_socket_path.c_str());
+        if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 64) != 0) {
+            ::close(listener);
+            throw std::runtime_error { "unable to listen on \"" + _socket_path + "\"" };
+        }
+
+        for (;;) {
+            const int fd = ::accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                // Anything else, like running out of descriptors, lasts a while, don't spin on it
+                if (errno != EINTR && errno != ECONNABORTED) {
+                    std::this_thread::sleep_for(SERVER_ACCEPT_BACKOFF);
+                }
+                continue;
+            }
+            std::thread { [this, fd] {
+                // A client that manages to break the connection thread must not take the whole daemon down
+                try {
+                    serveConnection(fd);
+                }
+                catch (std::exception&) {
+                    ::close(fd);
+                }
+            } }.detach();
+        }
+#endif
+    }
+};
+}
+
+#endif // _SERVER_HPP_
@@ -0,0 +1,82 @@
+// Created: 2026-10-16
+
+#ifndef _STREAM_APPLY_HPP_
+#define _STREAM_APPLY_HPP_
+
+#include "apply.hpp"
+#include "image.hpp"
+#include "png.hpp"
+#include "row_io.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Target size of a band of RGBA rows held in memory by streaming application, 64 MiB
+inline static constexpr std::size_t STREAM_BAND_BYTES = static_cast<std::size_t>(1) << 26;
+
+/// \brief Pixel count from which the CLI streams images instead of loading them whole, 64 Mpx (256 MiB of RGBA)
+inline static constexpr std::uint64_t STREAM_MIN_PIXELS = static_cast<std::uint64_t>(1) << 26;
+
+/// \brief Applies a LUT to an image streamed from a reader to a writer, one band of rows at a time
+/// \details Peak memory is one band of RGBA pixels plus what the codecs buffer, whatever the size of the image.
+/// \param lut Anything \c applyLUT accepts for a range of pixels: a LUT cache, a \c LutView or a \c LatticeLut
+/// \param pool The pool to spread application and encoding across; runs on the calling thread if \c nullptr
+/// \param band_rows Number of rows per band, 0 for about \c STREAM_BAND_BYTES worth
+template <typename LutTy>
+void applyLUT(RowReader& reader, RowWriter& writer, const LutTy& lut, ThreadPool* pool = nullptr, std::size_t band_rows = 0) {
+    const std::size_t w = static_cast<std::size_t>(reader.getWidth());
+    const std::size_t h = static_cast<std::size_t>(reader.getHeight());
+    if (!band_rows) {
+        band_rows = std::max<std::size_t>(1, STREAM_BAND_BYTES / (w * sizeof(Color)));
+    }
+    band_rows = std::min(band_rows, h);
+
+    std::vector<Color> band(band_rows * w);
+    for (std::size_t y = 0; y < h; y += band_rows) {
+        const std::size_t rows = std::min(band_rows, h - y);
+        reader.readRows(band.data(), rows);
+        applyLUT(band.data(), band.data() + rows * w, lut, pool);
+        writer.writeRows(band.data(), rows, pool);
+    }
+    writer.finish();
+}
+
+/// \brief Applies a LUT to an image file, streaming it one band of rows at a time
+/// \param input_file PNG, PGM, PPM or PAM image
+/// \param output_file PNG, PPM or PAM image; a PPM drops alpha
+/// \param lut Anything \c applyLUT accepts for a range of pixels: a LUT cache, a \c LutView or a \c LatticeLut
+/// \param pool The pool to spread application and encoding across; runs on the calling thread if \c nullptr
+/// \param png_effort Trade-off between PNG file size and encoding speed
+/// \param band_rows Number of rows per band, 0 for about \c STREAM_BAND_BYTES worth
+template <typename LutTy>
+void applyLUT(
+    const std::string& input_file,
+    const std::string& output_file,
+    const LutTy& lut,
+    ThreadPool* pool = nullptr,
+    PngEffort png_effort = PngEffort::Default,
+    std::size_t band_rows = 0) {
+    if (Pathutils::isSameFile(input_file, output_file)) {
+        // Opening the output would truncate the input before it's read
+        throw std::runtime_error { "can't stream image file \"" + input_file + "\" onto itself" };
+    }
+    const std::unique_ptr<RowReader> reader = openRowReader(input_file);
+    if (!reader) {
+        throw std::runtime_error { "can't stream image file \"" + input_file + "\"" };
+    }
+    const std::unique_ptr<RowWriter> writer = openRowWriter(output_file, reader->getWidth(), reader->getHeight(), png_effort);
+    if (!writer) {
+        throw std::runtime_error { "can't stream to image file \"" + output_file + "\"" };
+    }
+    applyLUT(*reader, *writer, lut, pool, band_rows);
+}
+}
+
+#endif // _STREAM_APPLY_HPP_
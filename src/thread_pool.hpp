@@ -0,0 +1,242 @@
+// Created: 2026-10-16
+
+#ifndef _THREAD_POOL_HPP_
+#define _THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Lutools {
+
+/// \brief Most worker threads a pool starts, whatever it's asked for
+inline static constexpr unsigned THREAD_POOL_MAX_CONCURRENCY = 256;
+
+/// \brief Fixed-size work-stealing thread pool
+/// \details Every worker owns a task deque: it pops its own tasks LIFO, and once that runs dry, steals from the others FIFO.
+/// Tasks submitted from inside a worker land in that worker's own deque, so nested work stays local until someone idles.
+class ThreadPool {
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> _queues;
+    std::vector<std::thread> _threads;
+
+    std::mutex _state_mutex;
+    std::condition_variable _task_available;
+    std::condition_variable _all_done;
+    std::size_t _queued = 0; // Sitting in some deque
+    std::size_t _pending = 0; // Submitted but not yet finished
+    bool _stopping = false;
+
+    std::atomic<std::size_t> _next_queue { 0 };
+
+    inline static thread_local const ThreadPool* _current_pool = nullptr;
+    inline static thread_local std::size_t _current_index = 0;
+
+    bool tryPop(std::size_t index, std::function<void()>& task) {
+        // Own deque first, newest task (hottest in cache)
+        {
+            TaskQueue& own = *_queues[index];
+            std::lock_guard<std::mutex> lk { own.mutex };
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+
+        // Then steal the oldest task of someone else
+        for (std::size_t i = 1; i < _queues.size(); ++i) {
+            TaskQueue& victim = *_queues[(index + i) % _queues.size()];
+            std::lock_guard<std::mutex> lk { victim.mutex };
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(std::size_t index) {
+        _current_pool = this;
+        _current_index = index;
+
+        std::function<void()> task;
+        for (;;) {
+            if (tryPop(index, task)) {
+                {
+                    std::lock_guard<std::mutex> lk { _state_mutex };
+                    --_queued;
+                }
+                task();
+                task = nullptr;
+
+                std::lock_guard<std::mutex> lk { _state_mutex };
+                if (--_pending == 0) {
+                    _all_done.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lk { _state_mutex };
+            _task_available.wait(lk, [this] { return _stopping || _queued > 0; });
+            if (_stopping && _queued == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+#pragma region Non-copyable, non-movable
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+#pragma endregion
+
+    /// \brief Starts the workers
+    /// \param concurrency Number of worker threads, up to \c THREAD_POOL_MAX_CONCURRENCY; 0 for
+    /// \c std::thread::hardware_concurrency()
+    explicit ThreadPool(unsigned concurrency = 0) {
+        if (!concurrency) {
+            concurrency = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        concurrency = std::min(concurrency, THREAD_POOL_MAX_CONCURRENCY);
+        _queues.reserve(concurrency);
+        for (unsigned i = 0; i < concurrency; ++i) {
+            _queues.push_back(std::make_unique<TaskQueue>());
+        }
+        _threads.reserve(concurrency);
+        for (unsigned i = 0; i < concurrency; ++i) {
+            _threads.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    /// \brief Finishes every submitted task, then joins the workers
+    ~ThreadPool() noexcept {
+        {
+            std::lock_guard<std::mutex> lk { _state_mutex };
+            _stopping = true;
+        }
+        _task_available.notify_all();
+        for (std::thread& th: _threads) {
+            th.join();
+        }
+    }
+
+    /// \brief Returns the number of worker threads
+    std::size_t getConcurrency() const noexcept { return _threads.size(); }
+
+    /// \brief Checks if the calling thread is one of this pool's workers
+    bool isWorkerThread() const noexcept { return _current_pool == this; }
+
+    /// \brief Queues a task
+    /// \param task Any callable taking no argument; it \b must handle its own exceptions, just like a \c std::thread body
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lk { _state_mutex };
+            ++_queued;
+            ++_pending;
+        }
+
+        const std::size_t index = isWorkerThread() ? _current_index : _next_queue++ % _queues.size();
+        {
+            TaskQueue& queue = *_queues[index];
+            std::lock_guard<std::mutex> lk { queue.mutex };
+            queue.tasks.push_back(std::move(task));
+        }
+        _task_available.notify_one();
+    }
+
+    /// \brief Blocks until every submitted task is finished
+    /// \remark DO NOT call this from inside a task, it will never return
+    void wait() {
+        std::unique_lock<std::mutex> lk { _state_mutex };
+        _all_done.wait(lk, [this] { return _pending == 0; });
+    }
+};
+
+/// \brief Runs \c fn(chunk_begin, chunk_end) over every \c grain -sized chunk of the index range [begin, end)
+/// \param pool The pool to spread the chunks across; everything runs on the calling thread if \c nullptr
+/// \param begin The first index
+/// \param end One past the last index
+/// \param grain Number of indices per chunk
+/// \param fn The chunk body
+/// \remark The calling thread works on chunks too, so it is safe to call this from inside a task of the same pool;
+/// returns after every chunk is done, rethrowing the first exception thrown by \c fn
+template <typename FnTy>
+void parallelFor(ThreadPool* pool, std::size_t begin, std::size_t end, std::size_t grain, FnTy&& fn) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (end - begin + grain - 1) / grain;
+    if (!pool || chunks == 1 || pool->getConcurrency() < 2) {
+        fn(begin, end);
+        return;
+    }
+
+    // Outlives this call, since helpers still sitting in deques will peek at it
+    struct State {
+        std::atomic<std::size_t> next { 0 };
+        std::atomic<bool> failed { false };
+        std::size_t done = 0;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    const auto state = std::make_shared<State>();
+
+    // Claims chunks until none is left
+    const auto run = [state, chunks, begin, end, grain, body = &fn] {
+        std::size_t chunk;
+        while ((chunk = state->next++) < chunks) {
+            if (!state->failed) {
+                try {
+                    const std::size_t chunk_begin = begin + chunk * grain;
+                    (*body)(chunk_begin, std::min(chunk_begin + grain, end));
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lk { state->mutex };
+                    if (!state->error) {
+                        state->error = std::current_exception();
+                    }
+                    state->failed = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lk { state->mutex };
+            if (++state->done == chunks) {
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    const std::size_t helpers = std::min(pool->getConcurrency(), chunks - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        pool->submit(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lk { state->mutex };
+    state->finished.wait(lk, [&] { return state->done == chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+}
+
+#endif // _THREAD_POOL_HPP_
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Created: 2026-10-16
+# Closing the output of -pipe early must fail the run, rather than hang it on a reader still waiting for input
+# Usage: pipe_output_closed.sh LUTOOLS
+set -u
+
+lutools=$1
+dir=$(mktemp -d)
+trap 'exec 3>&-; rm -rf "$dir"' EXIT
+
+# Identity cube, small to parse
+printf 'LUT_3D_SIZE 2\n0 0 0\n1 0 0\n0 1 0\n1 1 0\n0 0 1\n1 0 1\n0 1 1\n1 1 1\n' > "$dir/identity.cube"
+
+# Held open both ways, so the input never ends, and the reader stays blocked after the first frame
+mkfifo "$dir/frames"
+exec 3<> "$dir/frames"
+# A frame larger than a pipe holds, so its write can only fail once the output is gone
+frame_bytes=$((256 * 256 * 3))
+head -c "$frame_bytes" /dev/zero >&3 &
+
+# Failed writes are reported as errors instead of killing the process
+trap '' PIPE
+timeout 30 "$lutools" -pipe 256x256:rgb24 "$dir/identity.cube" <&3 2> "$dir/stderr" | true
+status=${PIPESTATUS[0]}
+wait
+
+if [ "$status" -eq 124 ]; then
+    echo "hung after the output was closed"
+    exit 1
+fi
+if [ "$status" -ne 1 ] || ! grep -q "failed to write frame" "$dir/stderr"; then
+    echo "unexpected exit status $status:"
+    cat "$dir/stderr"
+    exit 1
+fi